@@ -13,10 +13,14 @@
 #define AM_BACKUP_DOMAIN_START_ADDRESS         0x40081120
 #define AM_BACKUP_DOMAIN_SIZE_IN_BYTES         480
 
+#define AM_MAX_SAMPLES_IN_DMA_TRANSFER         1024
+
 #define AM_UNIQUE_ID_START_ADDRESS             0xFE081F0
 #define AM_UNIQUE_ID_SIZE_IN_BYTES             8
 
-/* Switch and battery state enumerations */
+#define AM_TIME_TICKS_PER_SECOND               256
+
+/* Switch, battery state and LED enumerations */
 
 typedef enum {AM_SWITCH_CUSTOM, AM_SWITCH_DEFAULT, AM_SWITCH_USB, AM_SWITCH_NONE} AM_switchPosition_t;
 
@@ -24,6 +28,8 @@ typedef enum {AM_HFRCO_1MHZ, AM_HFRCO_7MHZ, AM_HFRCO_11MHZ, AM_HFRCO_14MHZ, AM_H
 
 typedef enum {AM_BATTERY_LOW, AM_BATTERY_3V6, AM_BATTERY_3V7, AM_BATTERY_3V8, AM_BATTERY_3V9, AM_BATTERY_4V0, AM_BATTERY_4V1, AM_BATTERY_4V2, AM_BATTERY_4V3, AM_BATTERY_4V4, AM_BATTERY_4V5, AM_BATTERY_4V6, AM_BATTERY_4V7, AM_BATTERY_4V8, AM_BATTERY_4V9, AM_BATTERY_FULL } AM_batteryState_t;
 
+typedef enum {AM_LED_RED, AM_LED_GREEN, AM_LED_BOTH} AM_LED_t;
+
 /* Interrupt handlers */
 
 extern void AudioMoth_handleSwitchInterrupt(void);
@@ -40,6 +46,13 @@ extern void AudioMoth_usbApplicationPacketReceived(uint32_t messageType, uint8_t
 void AudioMoth_initialise(void);
 bool AudioMoth_isInitialPowerUp(void);
 
+/* Fast resume from scheduled wakes */
+
+void AudioMoth_requestFastResume(void);
+bool AudioMoth_isFastResume(void);
+
+uint32_t AudioMoth_getMillisecondsSinceWake(void);
+
 /* Debugging */
 
 void AudioMoth_setUpDebugOutput(void);
@@ -56,6 +69,12 @@ void AudioMoth_disableHFRCO(void);
 
 void AudioMoth_calibrateHFRCO(uint32_t frequency);
 
+uint32_t AudioMoth_getHFRCOTuning(void);
+void AudioMoth_setHFRCOTuning(uint32_t tuning);
+
+int32_t AudioMoth_measureHFRCOError(uint32_t frequency);
+int32_t AudioMoth_refineHFRCO(uint32_t frequency, uint32_t maximumSteps);
+
 uint32_t AudioMoth_getClockFrequency(AM_clockFrequency_t frequency);
 
 /* External SRAM control */
@@ -74,6 +93,12 @@ uint32_t AudioMoth_calculateSampleRate(uint32_t frequency, uint32_t clockDivider
 void AudioMoth_enableMicrophone(uint32_t gain, uint32_t clockDivider, uint32_t acquisitionCycles, uint32_t oversampleRate);
 void AudioMoth_disableMicrophone(void);
 
+/* Wake on loud sound */
+
+void AudioMoth_enableSoundWake(uint32_t gain, uint32_t threshold);
+bool AudioMoth_sleepUntilSound(uint32_t seconds);
+void AudioMoth_disableSoundWake(void);
+
 /* USB */
 
 void AudioMoth_handleUSB(void);
@@ -86,6 +111,7 @@ void AudioMoth_storeInBackupDomain(uint32_t register, uint32_t value);
 /* Time */
 
 uint32_t AudioMoth_getTime(void);
+uint32_t AudioMoth_getTimeAndTicks(uint32_t *ticks);
 bool AudioMoth_hasTimeBeenSet(void);
 void AudioMoth_setTime(uint32_t time);
 
@@ -100,6 +126,7 @@ bool AudioMoth_hasWatchdogResetOccured(void);
 /* Battery state monitoring */
 
 AM_batteryState_t AudioMoth_getBatteryState();
+AM_batteryState_t AudioMoth_measureBatteryState();
 
 /* Switch position monitoring */
 
@@ -121,6 +148,11 @@ void AudioMoth_setRedLED(bool state);
 void AudioMoth_setBothLED(bool state);
 void AudioMoth_setGreenLED(bool state);
 
+void AudioMoth_startLEDPattern(AM_LED_t led, uint32_t numberOfFlashes, uint32_t onMilliseconds, uint32_t offMilliseconds);
+void AudioMoth_stopLEDPattern(void);
+bool AudioMoth_isLEDPatternActive(void);
+void AudioMoth_waitForLEDPattern(void);
+
 /* File system */
 
 bool AudioMoth_enableFileSystem();
@@ -132,6 +164,7 @@ bool AudioMoth_readFile(char *filename, int16_t *buffer, uint32_t bufferSize);
 bool AudioMoth_appendFile(char *filename);
 
 bool AudioMoth_seekInFile(uint32_t position);
+uint32_t AudioMoth_getFileSize(void);
 bool AudioMoth_writeToFile(void *bytes, uint32_t bytesToWrite);
 
 bool AudioMoth_renameFile(char *originalFilename, char *newFilename);
@@ -0,0 +1,32 @@
+/****************************************************************************
+ * clockband.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef CLOCKBAND_H_
+#define CLOCKBAND_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Percentage of each buffer period kept free when choosing a clock band */
+
+#define CLOCK_BAND_SAFETY_MARGIN            50
+
+/* Percentage by which the HFRCO may be tuned away from the nominal band frequency */
+
+#define CLOCK_BAND_TUNING_RANGE             15
+
+typedef struct {
+    uint32_t clockBand;
+    uint32_t acquisitionCycles;
+    uint32_t oversampleRate;
+} clockBandSelection_t;
+
+/* Choose the lowest band which processes a buffer within the safety margin of its deadline, and which can */
+/* be tuned to give the sample rate with some ADC acquisition and oversample setting. Returns false if none can */
+
+bool selectClockBand(const uint32_t *bandFrequencies, uint32_t numberOfBands, uint32_t sampleRate, uint32_t clockDivider, uint32_t samplesPerBuffer, uint32_t cyclesPerBuffer, clockBandSelection_t *selection);
+
+#endif /* CLOCKBAND_H_ */
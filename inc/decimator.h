@@ -0,0 +1,49 @@
+/****************************************************************************
+ * decimator.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef DECIMATOR_H_
+#define DECIMATOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <arm_math.h>
+
+/* Largest supported ratio between the capture rate and the output rate */
+
+#define DECIMATOR_MAXIMUM_FACTOR            6
+
+/* Filter length for each polyphase branch, so the full filter has this many taps for each input sample per output sample */
+
+#define DECIMATOR_TAPS_PER_PHASE            24
+
+#define DECIMATOR_MAXIMUM_TAPS              (DECIMATOR_TAPS_PER_PHASE * DECIMATOR_MAXIMUM_FACTOR)
+
+/* Largest block of input samples which can be decimated in one call */
+
+#define DECIMATOR_MAXIMUM_BLOCK_SIZE        1024
+
+/* Windowed sinc low pass filter, with its cutoff at the output Nyquist frequency, and the history between blocks */
+
+typedef struct {
+#ifdef ARM_MATH_CM4
+    arm_fir_decimate_instance_q15 instance;
+#else
+    uint32_t factor;
+    uint32_t numberOfTaps;
+#endif
+    int16_t coefficients[DECIMATOR_MAXIMUM_TAPS];
+    int16_t state[DECIMATOR_MAXIMUM_TAPS + DECIMATOR_MAXIMUM_BLOCK_SIZE - 1];
+} decimator_t;
+
+/* Design the filter and clear the history. Returns false if the block size is too large or not a multiple of the factor */
+
+bool initialiseDecimator(decimator_t *decimator, uint32_t factor, uint32_t blockSize);
+
+/* Filter a block of the size given at initialisation, writing blockSize / factor output samples */
+
+void decimate(decimator_t *decimator, int16_t *input, int16_t *output, uint32_t blockSize);
+
+#endif /* DECIMATOR_H_ */
@@ -8,4 +8,45 @@
 #include <stdint.h>
 #include <arm_math.h>
 
-bool detected(int16_t* buffer1, int16_t* buffer2);
+#include "modelfile.h"
+
+/* The detector analyses pairs of buffers, each containing two seconds of audio at 8kHz */
+
+#define DETECTOR_SAMPLE_RATE    8000
+
+#define DETECTOR_BUFFER_SIZE    16000
+
+uint32_t detected(int16_t* buffer1, int16_t* buffer2);
+
+/* Number of Goertzel bands, and of frames for each band, in the features of a pair of buffers */
+
+uint32_t getNumberOfFeatureBands(void);
+
+uint32_t getNumberOfFeatureFrames(void);
+
+/* Samples in each feature frame, and the centre frequency of each band */
+
+uint32_t getFeatureWindowLength(void);
+
+float getFeatureBandFrequency(uint32_t band);
+
+/* Fill one array of getNumberOfFeatureFrames() amplitudes for each band from a pair of buffers */
+
+void extractFeatures(int16_t* buffer1, int16_t* buffer2, float *values[]);
+
+/* Decode features laid out as by extractFeatures() with every model, returning a bit for each detection */
+
+uint32_t detectFromFeatures(float *values[]);
+
+/* First frame in a detection state on the most likely path of any model which detected in the last call to */
+/* detectFromFeatures() or detected(), or -1 if there was no detection. Frame t starts at sample t * getFeatureWindowLength() of the pair */
+
+int16_t getDetectionOnsetFrame(void);
+
+/* Last frame in a detection state on the same paths, or -1 if there was no detection */
+
+int16_t getDetectionEndFrame(void);
+
+/* Use the models in a model file if it is valid for the Goertzel bank, otherwise the compiled in models. Returns true if the file is used */
+
+bool loadDetectorModels(const modelFile_t *modelFile);
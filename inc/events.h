@@ -0,0 +1,44 @@
+/****************************************************************************
+ * events.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <stdint.h>
+
+/* Each detection is appended to the events file as a fixed size binary record, with a bit for each model which detected its sound */
+/* The onset is the start of the first detection frame, timed from the counter latched at the end of each buffer, and is zero if unknown */
+
+/* The file starts with a header giving the layout of its records. The version is also in the file name, so a card which spans a */
+/* firmware update keeps each layout in its own file. Change both whenever the record changes */
+
+#define EVENTS_FILENAME                     "EVENTS03.BIN"
+
+#define EVENTS_FILE_MAGIC                   "AMEV"
+#define EVENTS_FILE_VERSION                 3
+
+#define EVENT_FLAG_LOG_ONLY                 0x01
+
+#pragma pack(push, 1)
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t recordSize;
+} eventsFileHeader_t;
+
+typedef struct {
+    uint32_t time;
+    uint8_t flags;
+    uint8_t batteryState;
+    uint8_t detections;
+    uint32_t onsetTime;
+    uint16_t onsetMilliseconds;
+} eventRecord_t;
+
+#pragma pack(pop)
+
+#endif /* EVENTS_H_ */
@@ -0,0 +1,83 @@
+/****************************************************************************
+ * goertzelbank.h
+ * openacousticdevices.info
+ *
+ * Generated by tools/goertzelgen.c, do not edit. Regenerate with:
+ * goertzelgen -r 8000 -w 128 -p -1 -s 14 350 1300 3500
+ *****************************************************************************/
+
+#ifndef GOERTZELBANK_H_
+#define GOERTZELBANK_H_
+
+#define GOERTZEL_SAMPLE_RATE                8000
+#define GOERTZEL_WINDOW_LENGTH              128
+#define GOERTZEL_NUMBER_OF_BANDS            3
+
+#define GOERTZEL_BAND_FREQUENCIES           {350.0f, 1300.0f, 3500.0f}
+
+#define GOERTZEL_COEFFICIENT_0              1.92491047f     /* 2*cos(2*pi*350/8000) */
+#define GOERTZEL_COEFFICIENT_1              1.04499713f     /* 2*cos(2*pi*1300/8000) */
+#define GOERTZEL_COEFFICIENT_2              -1.84775907f    /* 2*cos(2*pi*3500/8000) */
+
+#define GOERTZEL_COEFFICIENTS               {GOERTZEL_COEFFICIENT_0, GOERTZEL_COEFFICIENT_1, GOERTZEL_COEFFICIENT_2}
+
+/* 128 Hamming factors / 2^14 */
+
+static float goertzelWindow[GOERTZEL_WINDOW_LENGTH] = {
+    1.778936397e-05f, 1.664839870e-05f, 1.554672706e-05f, 1.448700308e-05f,
+    1.347177971e-05f, 1.250350273e-05f, 1.158450479e-05f, 1.071699985e-05f,
+    9.903077797e-06f, 9.144699442e-06f, 8.443691786e-06f, 7.801743616e-06f,
+    7.220401443e-06f, 6.701065771e-06f, 6.244987725e-06f, 5.853266036e-06f,
+    5.526844397e-06f, 5.266509186e-06f, 5.072887574e-06f, 4.946446011e-06f,
+    4.887489107e-06f, 4.896158893e-06f, 4.972434484e-06f, 5.116132125e-06f,
+    5.326905636e-06f, 5.604247245e-06f, 5.947488812e-06f, 6.355803437e-06f,
+    6.828207456e-06f, 7.363562804e-06f, 7.960579766e-06f, 8.617820073e-06f,
+    9.333700378e-06f, 1.010649606e-05f, 1.093434539e-05f, 1.181525400e-05f,
+    1.274709971e-05f, 1.372763763e-05f, 1.475450554e-05f, 1.582522963e-05f,
+    1.693723044e-05f, 1.808782906e-05f, 1.927425360e-05f, 2.049364585e-05f,
+    2.174306819e-05f, 2.301951066e-05f, 2.431989819e-05f, 2.564109803e-05f,
+    2.697992731e-05f, 2.833316066e-05f, 2.969753802e-05f, 3.106977249e-05f,
+    3.244655824e-05f, 3.382457846e-05f, 3.520051340e-05f, 3.657104829e-05f,
+    3.793288141e-05f, 3.928273198e-05f, 4.061734808e-05f, 4.193351451e-05f,
+    4.322806051e-05f, 4.449786741e-05f, 4.573987613e-05f, 4.695109457e-05f,
+    4.812860478e-05f, 4.926957005e-05f, 5.037124169e-05f, 5.143096567e-05f,
+    5.244618904e-05f, 5.341446602e-05f, 5.433346396e-05f, 5.520096890e-05f,
+    5.601489095e-05f, 5.677326931e-05f, 5.747427696e-05f, 5.811622513e-05f,
+    5.869756731e-05f, 5.921690298e-05f, 5.967298103e-05f, 6.006470271e-05f,
+    6.039112435e-05f, 6.065145956e-05f, 6.084508118e-05f, 6.097152274e-05f,
+    6.103047964e-05f, 6.102180986e-05f, 6.094553427e-05f, 6.080183662e-05f,
+    6.059106311e-05f, 6.031372150e-05f, 5.997047994e-05f, 5.956216531e-05f,
+    5.908976129e-05f, 5.855440595e-05f, 5.795738898e-05f, 5.730014868e-05f,
+    5.658426837e-05f, 5.581147269e-05f, 5.498362336e-05f, 5.410271475e-05f,
+    5.317086904e-05f, 5.219033112e-05f, 5.116346321e-05f, 5.009273912e-05f,
+    4.898073831e-05f, 4.783013969e-05f, 4.664371515e-05f, 4.542432290e-05f,
+    4.417490056e-05f, 4.289845809e-05f, 4.159807056e-05f, 4.027687072e-05f,
+    3.893804144e-05f, 3.758480809e-05f, 3.622043073e-05f, 3.484819626e-05f,
+    3.347141051e-05f, 3.209339029e-05f, 3.071745535e-05f, 2.934692046e-05f,
+    2.798508734e-05f, 2.663523677e-05f, 2.530062067e-05f, 2.398445424e-05f,
+    2.268990824e-05f, 2.142010134e-05f, 2.017809262e-05f, 1.896687418e-05f
+};
+
+/* Each band keeps its two delayed values in local variables declared by GOERTZEL_BANK_DECLARE */
+
+#define GOERTZEL_BANK_DECLARE() \
+    float goertzelDelay1_0 = 0.0f, goertzelDelay2_0 = 0.0f; \
+    float goertzelDelay1_1 = 0.0f, goertzelDelay2_1 = 0.0f; \
+    float goertzelDelay1_2 = 0.0f, goertzelDelay2_2 = 0.0f;
+
+#define GOERTZEL_BANK_UPDATE(sample) \
+    { float y = (sample) + GOERTZEL_COEFFICIENT_0 * goertzelDelay1_0 - goertzelDelay2_0; goertzelDelay2_0 = goertzelDelay1_0; goertzelDelay1_0 = y; } \
+    { float y = (sample) + GOERTZEL_COEFFICIENT_1 * goertzelDelay1_1 - goertzelDelay2_1; goertzelDelay2_1 = goertzelDelay1_1; goertzelDelay1_1 = y; } \
+    { float y = (sample) + GOERTZEL_COEFFICIENT_2 * goertzelDelay1_2 - goertzelDelay2_2; goertzelDelay2_2 = goertzelDelay1_2; goertzelDelay1_2 = y; }
+
+#define GOERTZEL_BANK_OUTPUT(values, index) \
+    arm_sqrt_f32(goertzelDelay1_0 * goertzelDelay1_0 + goertzelDelay2_0 * goertzelDelay2_0 - goertzelDelay1_0 * goertzelDelay2_0 * GOERTZEL_COEFFICIENT_0, &values[0][index]); \
+    arm_sqrt_f32(goertzelDelay1_1 * goertzelDelay1_1 + goertzelDelay2_1 * goertzelDelay2_1 - goertzelDelay1_1 * goertzelDelay2_1 * GOERTZEL_COEFFICIENT_1, &values[1][index]); \
+    arm_sqrt_f32(goertzelDelay1_2 * goertzelDelay1_2 + goertzelDelay2_2 * goertzelDelay2_2 - goertzelDelay1_2 * goertzelDelay2_2 * GOERTZEL_COEFFICIENT_2, &values[2][index]);
+
+#define GOERTZEL_BANK_RESET() \
+    goertzelDelay1_0 = 0.0f; goertzelDelay2_0 = 0.0f; \
+    goertzelDelay1_1 = 0.0f; goertzelDelay2_1 = 0.0f; \
+    goertzelDelay1_2 = 0.0f; goertzelDelay2_2 = 0.0f;
+
+#endif /* GOERTZELBANK_H_ */
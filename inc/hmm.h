@@ -4,8 +4,49 @@
  * March 2018
  *****************************************************************************/
 
+#ifndef HMM_H_
+#define HMM_H_
+
 #include <stdint.h>
 
+/* Largest model which can be decoded, and longest observation sequence */
+
+#define HMM_MAXIMUM_STATES          8
+
+#define HMM_MAXIMUM_FEATURES        8
+
+#define HMM_MAXIMUM_FRAMES          250
+
+#define HMM_MODEL_NAME_LENGTH       8
+
+/* Each model selects its features from the rows of the shared feature matrix, and detects when the number */
+/* of frames decoded as one of its detection states is within its limits */
+
+typedef struct {
+    char name[HMM_MODEL_NAME_LENGTH];
+    uint8_t numberOfStates;
+    uint8_t numberOfFeatures;
+    uint8_t featureIndices[HMM_MAXIMUM_FEATURES];
+    uint8_t detectionStates;
+    int16_t minimumDetectionFrames;
+    int16_t maximumDetectionFrames;
+    float emissionFloor;
+    float emissionMean[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+    float oneOverEmissionVariance[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+    float normalisationFactors[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+    float transitionMatrix[HMM_MAXIMUM_STATES][HMM_MAXIMUM_STATES];
+    float initial[HMM_MAXIMUM_STATES];
+} hmmModel_t;
+
 float FastExp(float x);
 float lognormalpdf(float X, float mu, float p1, float variance);
-int16_t calculate(float freq1[], float freq2[], float freq3[], int16_t T);
+
+/* Viterbi decode of T frames, returning the number of frames in the model's detection states */
+
+int16_t calculate(const hmmModel_t *model, float *features[], int16_t T);
+
+/* State of each frame on the most likely path found by the last call to calculate */
+
+const uint8_t* getMostProbableExplanation(void);
+
+#endif /* HMM_H_ */
@@ -0,0 +1,42 @@
+/****************************************************************************
+ * modelfile.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef MODELFILE_H_
+#define MODELFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hmm.h"
+
+/* Detection models can be replaced by a file on the SD card, read directly into this structure. The */
+/* layout is the little-endian, naturally aligned one shared by the device and the host tools */
+
+#define MODEL_FILENAME                      "MODEL.BIN"
+
+#define MODEL_FILE_MAGIC                    0x4C444F4D      /* "MODL" */
+#define MODEL_FILE_VERSION                  1
+
+#define MODEL_FILE_MAXIMUM_MODELS           4
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t numberOfModels;
+    hmmModel_t models[MODEL_FILE_MAXIMUM_MODELS];
+} modelFile_t;
+
+/* CRC-32 of everything following the crc field */
+
+uint32_t calculateModelFileCRC(const modelFile_t *modelFile);
+
+/* Check the header, the checksum and that every model fits the decoder and the given number of feature bands */
+
+bool validateModelFile(const modelFile_t *modelFile, uint32_t numberOfBands);
+
+#endif /* MODELFILE_H_ */
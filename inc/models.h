@@ -0,0 +1,29 @@
+/****************************************************************************
+ * models.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef MODELS_H_
+#define MODELS_H_
+
+#include "hmm.h"
+#include "modelfile.h"
+
+/* Models decoded from the shared Goertzel features, in the order of the bits returned by detected() */
+
+#define MAXIMUM_NUMBER_OF_DETECTOR_MODELS   MODEL_FILE_MAXIMUM_MODELS
+
+#if MAXIMUM_NUMBER_OF_DETECTOR_MODELS > 8
+#error "Detections are stored as one byte in the event record"
+#endif
+
+extern const hmmModel_t *detectorModels[MAXIMUM_NUMBER_OF_DETECTOR_MODELS];
+
+extern uint32_t numberOfDetectorModels;
+
+/* Use the models from a validated model file, or the compiled in models if it is NULL */
+
+void useDetectorModels(const modelFile_t *modelFile);
+
+#endif /* MODELS_H_ */
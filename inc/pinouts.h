@@ -17,6 +17,10 @@
 #define BAT_MON_GPIOPORT                        gpioPortC
 #define BAT_MON_EN                              3
 
+/* SOUND WAKE COMPARATOR, ACMP1 INPUT WHICH THE AMPLIFIER OUTPUT MUST BE CONNECTED TO */
+
+#define MIC_ACMP_CHANNEL                        acmpChannel0
+
 /* LED GPIO */
 
 #define LED_GPIOPORT                            gpioPortC
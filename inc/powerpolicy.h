@@ -0,0 +1,58 @@
+/****************************************************************************
+ * powerpolicy.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef POWERPOLICY_H_
+#define POWERPOLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Levels in order of increasing battery saving */
+
+typedef enum {
+    POWER_POLICY_FULL,
+    POWER_POLICY_ALTERNATE_PAIRS,
+    POWER_POLICY_PRIORITY_HOURS,
+    POWER_POLICY_PRIORITY_HOURS_ALTERNATE_PAIRS,
+    NUMBER_OF_POWER_POLICY_LEVELS
+} powerPolicyLevel_t;
+
+/* Interval between battery measurements */
+
+#define POWER_POLICY_UPDATE_INTERVAL        (6 * 60 * 60)
+
+/* Battery steps which must be used before a consumption rate is estimated */
+
+#define POWER_POLICY_MINIMUM_DROP           2
+
+/* Percentage by which the projected exhaustion must pass the target before saving is relaxed */
+
+#define POWER_POLICY_RELAX_MARGIN           25
+
+/* State kept in the backup domain between wakes */
+
+typedef struct {
+    uint32_t level;
+    uint32_t timeOfLastUpdate;
+    uint32_t referenceTime;
+    uint32_t referenceBatteryState;
+    uint32_t projectedTimeOfExhaustion;
+} powerPolicyState_t;
+
+void initialisePowerPolicy(powerPolicyState_t *state);
+
+bool isPowerPolicyUpdateDue(powerPolicyState_t *state, uint32_t currentTime);
+
+/* Update the consumption model with a battery measurement and choose the level which reaches the target time */
+/* The battery state is an AM_batteryState_t and a target time of zero disables the policy */
+
+powerPolicyLevel_t updatePowerPolicy(powerPolicyState_t *state, uint32_t currentTime, uint32_t batteryState, uint32_t targetTime);
+
+bool powerPolicyAnalysesAlternatePairs(powerPolicyLevel_t level);
+
+bool powerPolicyAllowsHour(powerPolicyLevel_t level, uint32_t priorityHours, uint32_t hour);
+
+#endif /* POWERPOLICY_H_ */
@@ -0,0 +1,95 @@
+/****************************************************************************
+ * profiler.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+
+/* Pipeline stages which can be timed */
+
+typedef enum {
+    PROFILE_DETECTION,
+    PROFILE_GOERTZEL,
+    PROFILE_HMM,
+    PROFILE_HMM_FORWARD,
+    PROFILE_HMM_BACKTRACK,
+    PROFILE_GMTIME,
+    PROFILE_SD_INITIALISATION,
+    PROFILE_SD_WRITE,
+    PROFILE_BOOT_TO_FIRST_SAMPLE,
+    PROFILE_WAKES_PER_BUFFER,
+    NUMBER_OF_PROFILE_STAGES
+} profileStage_t;
+
+/* Each histogram bin counts the samples between consecutive powers of two */
+
+#define NUMBER_OF_PROFILE_BINS              32
+
+/* Timing macros compile to nothing unless ENABLE_PROFILING is defined */
+/* A PROFILE_START and its PROFILE_STOP must be in the same scope */
+
+#ifdef ENABLE_PROFILING
+
+#define PROFILE_INITIALISE() initialiseProfiler();
+
+#define PROFILE_START(stage) uint32_t profileStartOf ## stage = getProfileCount();
+
+#define PROFILE_STOP(stage) recordProfileSample(stage, getProfileCount() - profileStartOf ## stage);
+
+#define PROFILE_RECORD(stage, count) recordProfileSample(stage, count);
+
+#else
+
+#define PROFILE_INITIALISE()
+
+#define PROFILE_START(stage)
+
+#define PROFILE_STOP(stage)
+
+#define PROFILE_RECORD(stage, count)
+
+#endif
+
+/* On the device counts are Cortex-M4 DWT cycles, on the host they are nanoseconds. Boot time is in milliseconds and wakes are a count */
+
+#ifdef ARM_MATH_CM4
+
+#include "em_device.h"
+
+#define PROFILE_UNITS                       "cycles"
+
+static inline uint32_t getProfileCount(void) {
+
+    return DWT->CYCCNT;
+
+}
+
+#else
+
+#define PROFILE_UNITS                       "ns"
+
+uint32_t getProfileCount(void);
+
+#endif
+
+void initialiseProfiler(void);
+
+/* The counter can be used without profiling, for example to calibrate the clock band */
+
+void enableProfileCounter(void);
+
+void resetProfileStatistics(void);
+
+void recordProfileSample(profileStage_t stage, uint32_t count);
+
+uint32_t getNumberOfProfileSamples(profileStage_t stage);
+
+/* Write one CSV line of statistics for a stage, returning the number of characters written */
+
+uint32_t formatProfileStatistics(profileStage_t stage, uint32_t currentTime, char *buffer, uint32_t size);
+
+#endif /* PROFILER_H_ */
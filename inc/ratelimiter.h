@@ -0,0 +1,28 @@
+/****************************************************************************
+ * ratelimiter.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef RATELIMITER_H_
+#define RATELIMITER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Token bucket kept in the backup domain between wakes */
+
+typedef struct {
+    uint32_t tokens;
+    uint32_t timeOfLastRefill;
+} rateLimiter_t;
+
+/* Start with a full bucket */
+
+void initialiseRateLimiter(rateLimiter_t *limiter, uint32_t capacity, uint32_t currentTime);
+
+/* Add one token for each refill interval elapsed, up to the capacity, then take a token if one is available */
+
+bool takeRateLimiterToken(rateLimiter_t *limiter, uint32_t capacity, uint32_t refillInterval, uint32_t currentTime);
+
+#endif /* RATELIMITER_H_ */
@@ -0,0 +1,32 @@
+/****************************************************************************
+ * schedule.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef SCHEDULE_H_
+#define SCHEDULE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_START_STOP_PERIODS              5
+
+/* A period runs from startMinutes (inclusive) to stopMinutes (exclusive) past midnight UTC */
+/* A period whose stop is earlier than its start crosses midnight, and a stop of 1440 means midnight */
+
+#pragma pack(push, 1)
+
+typedef struct {
+    uint16_t startMinutes;
+    uint16_t stopMinutes;
+} startStopPeriod_t;
+
+#pragma pack(pop)
+
+/* Calculates the absolute start and stop time of the listening window containing currentTime, or of the next one to begin */
+/* Contiguous and overlapping periods are merged into a single window. Returns false if no period is valid */
+
+bool calculateListeningWindow(startStopPeriod_t *periods, uint32_t numberOfPeriods, uint32_t currentTime, uint32_t *startTime, uint32_t *stopTime);
+
+#endif /* SCHEDULE_H_ */
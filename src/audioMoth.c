@@ -6,6 +6,7 @@
 
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -40,7 +41,7 @@
 
 /*  Define oscillator constants */
 
-#define AM_LFXO_TICKS_PER_SECOND                  256
+#define AM_LFXO_TICKS_PER_SECOND                  AM_TIME_TICKS_PER_SECOND
 #define AM_MINIMUM_POWER_DOWN_TIME                4
 
 /*  Define RTC backup register constants */
@@ -49,6 +50,9 @@
 #define AM_BURTC_CLOCK_SET_FLAG                   1
 #define AM_BURTC_WATCH_DOG_FLAG                   2
 #define AM_BURTC_INITIAL_POWER_UP_FLAG            3
+#define AM_BURTC_BATTERY_STATE                    4
+#define AM_BURTC_BATTERY_TIME                     5
+#define AM_BURTC_FAST_RESUME_FLAG                 6
 
 #define AM_BURTC_CANARY_VALUE                     0x11223344
 #define AM_BURTC_OVERFLOW_THRESHOLD               0x0100000000
@@ -58,6 +62,14 @@
 
 #define AM_BURTC_THRESHOLD_IN_SECONDS          (AM_BURTC_OVERFLOW_THRESHOLD / AM_LFXO_TICKS_PER_SECOND)
 
+/* Define battery monitor constants */
+
+#define AM_BATTERY_MIN_THRESHOLD                  34          // 3V3 * 2 * 34 / 63 = 3.6V
+#define AM_BATTERY_MAX_THRESHOLD                  48          // 3V3 * 2 * 48 / 63 = 5.0V
+
+#define AM_BATTERY_STATE_VALID_FLAG               0x100
+#define AM_BATTERY_STATE_MAXIMUM_AGE              300
+
 /* Define USB message types and declare buffers */
 
 #define AM_USB_BUFFERSIZE                         64
@@ -67,7 +79,10 @@
 #define AM_USB_MSG_TYPE_GET_UID                   0x03
 #define AM_USB_MSG_TYPE_GET_BATTERY               0x04
 
-#define MAX_SAMPLES_IN_DMA_TRANSFER               1024
+/* Define HFRCO calibration constants */
+
+#define AM_HFRCO_CALIBRATION_DOWN_CYCLES          0xC000
+#define AM_HFRCO_MAXIMUM_TUNING                   0xFF
 
 STATIC_UBUF(receiveBuffer, AM_USB_BUFFERSIZE);
 STATIC_UBUF(transmitBuffer, AM_USB_BUFFERSIZE);
@@ -83,6 +98,25 @@ static UINT bw;
 static DMA_CB_TypeDef cb;
 static uint16_t numberOfSamplesPerTransfer;
 
+/* Fast resume state */
+
+static bool fastResume;
+
+static uint32_t wakeCompareValue;
+
+/* LED pattern state, advanced by the BURTC compare interrupt */
+
+static volatile AM_LED_t patternLED;
+static volatile uint32_t patternStepsRemaining;
+static volatile bool patternActive;
+
+static uint32_t patternOnTicks;
+static uint32_t patternOffTicks;
+
+/* Sound wake state, set by the comparator interrupt */
+
+static volatile bool soundDetected;
+
 /* Function prototypes */
 
 static void setupGPIO(void);
@@ -90,6 +124,8 @@ static void enableEBI(void);
 static void disableEBI(void);
 static void setupBackupRTC(void);
 static void setupBackupDomain(void);
+static void handleBackupRTCOverflow(void);
+static void setLED(AM_LED_t led, bool state);
 static void setupWatchdogTimer(void);
 static void setupOpAmp(uint32_t gain);
 static bool batteryIsAboveVoltageThreshold(uint32_t vddLevelDivider);
@@ -107,16 +143,6 @@ void AudioMoth_initialise() {
 
     SystemInit();
 
-    /* Enable high frequency HFXO clock */
-
-    CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
-
-    CMU_ClockDivSet(cmuClock_HF, cmuClkDiv_1);
-
-    CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
-
-    CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
-
     /* Enable clock to low energy modules */
 
     CMU_ClockEnable(cmuClock_GPIO, true);
@@ -129,6 +155,26 @@ void AudioMoth_initialise() {
 
     RMU_ResetCauseClear();
 
+    /* A scheduled wake which requested fast resume stays on the HFRCO and leaves starting the HFXO to the application */
+
+    fastResume = (resetCause & RMU_RSTCAUSE_EM4WURST) && BURTC_RetRegGet(AM_BURTC_FAST_RESUME_FLAG) == AM_BURTC_CANARY_VALUE;
+
+    BURTC_RetRegSet(AM_BURTC_FAST_RESUME_FLAG, 0);
+
+    if (!fastResume) {
+
+        /* Enable high frequency HFXO clock */
+
+        CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
+
+        CMU_ClockDivSet(cmuClock_HF, cmuClkDiv_1);
+
+        CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+
+        CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
+
+    }
+
     /* If this is a start from power-off initialise low frequency oscillator and set up BURTC */
 
     if ((resetCause & RMU_RSTCAUSE_EM4WURST) == 0) {
@@ -155,21 +201,23 @@ void AudioMoth_initialise() {
 
         BURTC_RetRegSet(AM_BURTC_INITIAL_POWER_UP_FLAG,  AM_BURTC_CANARY_VALUE);
 
+        /* Invalidate the cached battery state */
+
+        BURTC_RetRegSet(AM_BURTC_BATTERY_STATE, 0);
+
     } else {
 
         /* Reset the BURTC counter if overflow flag has been set*/
 
         if (BURTC_IntGet() & BURTC_IF_OF) {
 
-            BURTC_IntClear(BURTC_IF_OF);
-
-            uint32_t offset = BURTC_RetRegGet(AM_BURTC_TIME_OFFSET);
+            handleBackupRTCOverflow();
 
-            BURTC_RetRegSet(AM_BURTC_TIME_OFFSET, offset + AM_BURTC_THRESHOLD_IN_SECONDS);
+        }
 
-            BURTC_IntEnable(BURTC_IF_OF);
+        /* Keep the compare value which woke the device before it is used for the LED */
 
-        }
+        wakeCompareValue = BURTC_CompareGet(0);
 
         /* Clear the initial power up flag */
 
@@ -185,6 +233,16 @@ void AudioMoth_initialise() {
 
     }
 
+    /* Enable BURTC interrupts for overflow and LED patterns */
+
+    BURTC_IntDisable(BURTC_IF_COMP0);
+
+    BURTC_IntClear(BURTC_IF_COMP0);
+
+    NVIC_ClearPendingIRQ(BURTC_IRQn);
+
+    NVIC_EnableIRQ(BURTC_IRQn);
+
     /* Put GPIO pins in correct state */
 
     setupGPIO();
@@ -217,6 +275,30 @@ bool AudioMoth_isInitialPowerUp(void) {
 
 }
 
+/* Fast resume control */
+
+void AudioMoth_requestFastResume(void) {
+
+    BURTC_RetRegSet(AM_BURTC_FAST_RESUME_FLAG, AM_BURTC_CANARY_VALUE);
+
+}
+
+bool AudioMoth_isFastResume(void) {
+
+    return fastResume;
+
+}
+
+/* Function to get the time since the BURTC compare value which woke the device */
+
+uint32_t AudioMoth_getMillisecondsSinceWake(void) {
+
+    uint32_t ticks = BURTC_CounterGet() - wakeCompareValue;
+
+    return (uint64_t)ticks * 1000 / AM_LFXO_TICKS_PER_SECOND;
+
+}
+
 /* Clock control */
 
 void AudioMoth_enableHFXO(void) {
@@ -276,7 +358,7 @@ void AudioMoth_calibrateHFRCO(uint32_t frequency) {
 
     /* Calculate expected number of up cycles */
 
-    uint32_t downCycles = 0xC000;
+    uint32_t downCycles = AM_HFRCO_CALIBRATION_DOWN_CYCLES;
 
     uint32_t targetUpCycles = (float)downCycles * (float)frequency / (float)CMU_ClockFreqGet(cmuClock_HF);
 
@@ -312,6 +394,70 @@ void AudioMoth_calibrateHFRCO(uint32_t frequency) {
 
 }
 
+uint32_t AudioMoth_getHFRCOTuning(void) {
+
+    return CMU_OscillatorTuningGet(cmuOsc_HFRCO);
+
+}
+
+void AudioMoth_setHFRCOTuning(uint32_t tuning) {
+
+    CMU_OscillatorTuningSet(cmuOsc_HFRCO, tuning);
+
+}
+
+/* Function to measure the HFRCO error from the target frequency in hundredths of a percent with a single calibration count */
+
+int32_t AudioMoth_measureHFRCOError(uint32_t frequency) {
+
+    uint32_t downCycles = AM_HFRCO_CALIBRATION_DOWN_CYCLES;
+
+    int32_t targetUpCycles = (float)downCycles * (float)frequency / (float)CMU_ClockFreqGet(cmuClock_HF);
+
+    int32_t actualUpCycles = CMU_Calibrate(downCycles, cmuOsc_HFRCO);
+
+    return (actualUpCycles - targetUpCycles) * 10000 / targetUpCycles;
+
+}
+
+/* Function to step the HFRCO tuning towards the target frequency, keeping the best value, and returning its error */
+
+int32_t AudioMoth_refineHFRCO(uint32_t frequency, uint32_t maximumSteps) {
+
+    uint32_t bestTuning = CMU_OscillatorTuningGet(cmuOsc_HFRCO);
+
+    int32_t bestError = AudioMoth_measureHFRCOError(frequency);
+
+    uint32_t tuning = bestTuning;
+
+    for (uint32_t step = 0; step < maximumSteps && bestError != 0; step += 1) {
+
+        /* HFRCO is running too fast if the error is positive, so reduce the tuning */
+
+        if (bestError > 0 && tuning == 0) break;
+
+        if (bestError < 0 && tuning == AM_HFRCO_MAXIMUM_TUNING) break;
+
+        tuning = bestError > 0 ? tuning - 1 : tuning + 1;
+
+        CMU_OscillatorTuningSet(cmuOsc_HFRCO, tuning);
+
+        int32_t error = AudioMoth_measureHFRCOError(frequency);
+
+        if (abs(error) >= abs(bestError)) break;
+
+        bestTuning = tuning;
+
+        bestError = error;
+
+    }
+
+    CMU_OscillatorTuningSet(cmuOsc_HFRCO, bestTuning);
+
+    return bestError;
+
+}
+
 uint32_t AudioMoth_getClockFrequency(AM_clockFrequency_t frequency) {
 
     switch (frequency) {
@@ -367,6 +513,62 @@ void ADC0_IRQHandler(void) {
 
 }
 
+void BURTC_IRQHandler(void) {
+
+    uint32_t interruptMask = BURTC_IntGet();
+
+    if (interruptMask & BURTC_IF_OF) {
+
+        handleBackupRTCOverflow();
+
+    }
+
+    if (interruptMask & BURTC_IF_COMP0) {
+
+        BURTC_IntClear(BURTC_IF_COMP0);
+
+        if (patternActive && patternStepsRemaining > 0) {
+
+            /* LED is on for even steps remaining and off for odd steps */
+
+            patternStepsRemaining -= 1;
+
+            bool state = (patternStepsRemaining & 1) == 0;
+
+            setLED(patternLED, state);
+
+            BURTC_CompareSet(0, BURTC_CounterGet() + (state ? patternOnTicks : patternOffTicks));
+
+        } else {
+
+            /* Pattern has finished, or the flag remains from the wake from EM4 */
+
+            setLED(patternLED, false);
+
+            patternActive = false;
+
+            BURTC_IntDisable(BURTC_IF_COMP0);
+
+        }
+
+    }
+
+}
+
+void ACMP0_IRQHandler(void) {
+
+    /* ACMP0 and ACMP1 share an interrupt, only ACMP1 has interrupts enabled */
+
+    if (ACMP_IntGet(ACMP1) & ACMP_IF_EDGE) {
+
+        ACMP_IntClear(ACMP1, ACMP_IF_EDGE);
+
+        soundDetected = true;
+
+    }
+
+}
+
 void TIMER1_IRQHandler(void) {
 
   /* Clear the TIMER1 overflow flag */
@@ -426,6 +628,20 @@ static void setupBackupDomain(void) {
 
 }
 
+/* Add the BURTC overflow period to the time offset */
+
+static void handleBackupRTCOverflow(void) {
+
+    BURTC_IntClear(BURTC_IF_OF);
+
+    uint32_t offset = BURTC_RetRegGet(AM_BURTC_TIME_OFFSET);
+
+    BURTC_RetRegSet(AM_BURTC_TIME_OFFSET, offset + AM_BURTC_THRESHOLD_IN_SECONDS);
+
+    BURTC_IntEnable(BURTC_IF_OF);
+
+}
+
 /* Configure RTC */
 
 static void setupBackupRTC(void) {
@@ -480,7 +696,7 @@ void AudioMoth_initialiseDirectMemoryAccess(int16_t *primaryBuffer, int16_t *sec
 
     numberOfSamplesPerTransfer = numberOfSamples;
 
-    if (numberOfSamplesPerTransfer > MAX_SAMPLES_IN_DMA_TRANSFER) numberOfSamplesPerTransfer = MAX_SAMPLES_IN_DMA_TRANSFER;
+    if (numberOfSamplesPerTransfer > AM_MAX_SAMPLES_IN_DMA_TRANSFER) numberOfSamplesPerTransfer = AM_MAX_SAMPLES_IN_DMA_TRANSFER;
 
     /* Start the clock */
 
@@ -555,6 +771,102 @@ void AudioMoth_enableMicrophone(uint32_t gain, uint32_t clockDivider, uint32_t a
 
 }
 
+/* Functions to wait in EM2 for the amplified microphone signal to cross a comparator threshold */
+
+void AudioMoth_enableSoundWake(uint32_t gain, uint32_t threshold) {
+
+    /* Enable microphone and VREF power, and the amplifier stage, which keep running in EM2 */
+
+    GPIO_PinOutClear(VMIC_GPIOPORT, VMIC_EN_N);
+
+    GPIO_PinOutSet(VREF_GPIOPORT, VREF_EN);
+
+    setupOpAmp(gain);
+
+    /* Compare the amplifier output against a fraction of VDD with the lowest bias current */
+
+    CMU_ClockEnable(cmuClock_ACMP1, true);
+
+    ACMP_Init_TypeDef acmp_init = ACMP_INIT_DEFAULT;
+
+    acmp_init.vddLevel = threshold;
+
+    acmp_init.hysteresisLevel = acmpHysteresisLevel2;
+
+    acmp_init.fullBias = false;
+
+    acmp_init.halfBias = true;
+
+    acmp_init.biasProg = 0;
+
+    acmp_init.lowPowerReferenceEnabled = true;
+
+    acmp_init.interruptOnRisingEdge = true;
+
+    ACMP_Init(ACMP1, &acmp_init);
+
+    ACMP_ChannelSet(ACMP1, acmpChannelVDD, MIC_ACMP_CHANNEL);
+
+    /* Wait for warm up */
+
+    while (!(ACMP1->STATUS & ACMP_STATUS_ACMPACT));
+
+    /* Enable the edge interrupt */
+
+    soundDetected = false;
+
+    ACMP_IntClear(ACMP1, ACMP_IF_EDGE);
+
+    ACMP_IntEnable(ACMP1, ACMP_IEN_EDGE);
+
+    NVIC_ClearPendingIRQ(ACMP0_IRQn);
+
+    NVIC_EnableIRQ(ACMP0_IRQn);
+
+}
+
+bool AudioMoth_sleepUntilSound(uint32_t seconds) {
+
+    /* Use the BURTC compare as a timeout once any LED pattern has finished */
+
+    AudioMoth_waitForLEDPattern();
+
+    BURTC_IntClear(BURTC_IF_COMP0);
+
+    BURTC_CompareSet(0, BURTC_CounterGet() + seconds * AM_LFXO_TICKS_PER_SECOND);
+
+    BURTC_IntEnable(BURTC_IF_COMP0);
+
+    /* Any interrupt ends the sleep, including the switch */
+
+    if (!soundDetected) {
+
+        EMU_EnterEM2(true);
+
+    }
+
+    BURTC_IntDisable(BURTC_IF_COMP0);
+
+    bool detected = soundDetected;
+
+    soundDetected = false;
+
+    return detected;
+
+}
+
+void AudioMoth_disableSoundWake(void) {
+
+    ACMP_IntDisable(ACMP1, ACMP_IEN_EDGE);
+
+    NVIC_DisableIRQ(ACMP0_IRQn);
+
+    ACMP_Disable(ACMP1);
+
+    CMU_ClockEnable(cmuClock_ACMP1, false);
+
+}
+
 void AudioMoth_disableMicrophone(void) {
 
     /* Stop the ADC interrupts */
@@ -818,6 +1130,72 @@ void AudioMoth_delay(uint16_t milliseconds) {
 
 }
 
+/* Functions to flash the LED without blocking. The pattern is stepped by the BURTC compare interrupt */
+
+void AudioMoth_startLEDPattern(AM_LED_t led, uint32_t numberOfFlashes, uint32_t onMilliseconds, uint32_t offMilliseconds) {
+
+    AudioMoth_stopLEDPattern();
+
+    if (numberOfFlashes == 0) return;
+
+    /* Round to at least one tick */
+
+    patternOnTicks = onMilliseconds * AM_LFXO_TICKS_PER_SECOND / 1000;
+
+    patternOffTicks = offMilliseconds * AM_LFXO_TICKS_PER_SECOND / 1000;
+
+    if (patternOnTicks == 0) patternOnTicks = 1;
+
+    if (patternOffTicks == 0) patternOffTicks = 1;
+
+    patternLED = led;
+
+    patternStepsRemaining = 2 * numberOfFlashes - 1;
+
+    patternActive = true;
+
+    setLED(led, true);
+
+    BURTC_IntClear(BURTC_IF_COMP0);
+
+    BURTC_CompareSet(0, BURTC_CounterGet() + patternOnTicks);
+
+    BURTC_IntEnable(BURTC_IF_COMP0);
+
+}
+
+void AudioMoth_stopLEDPattern(void) {
+
+    BURTC_IntDisable(BURTC_IF_COMP0);
+
+    if (patternActive) {
+
+        setLED(patternLED, false);
+
+        patternActive = false;
+
+    }
+
+}
+
+bool AudioMoth_isLEDPatternActive(void) {
+
+    return patternActive;
+
+}
+
+void AudioMoth_waitForLEDPattern(void) {
+
+    while (patternActive) {
+
+        AudioMoth_feedWatchdog();
+
+        EMU_EnterEM1();
+
+    }
+
+}
+
 void AudioMoth_sleep(void) {
 
     EMU_EnterEM1();
@@ -828,6 +1206,10 @@ void AudioMoth_sleep(void) {
 
 void AudioMoth_powerDown() {
 
+    /* Let any LED pattern finish */
+
+    AudioMoth_waitForLEDPattern();
+
     /* Set up GPIO pins */
 
     setupGPIO();
@@ -850,6 +1232,10 @@ void AudioMoth_powerDown() {
 
 void AudioMoth_powerDownAndWake(uint32_t seconds, bool synchronised) {
 
+    /* Let any LED pattern finish as it shares the BURTC compare */
+
+    AudioMoth_waitForLEDPattern();
+
     /* Put GPIO pins in power down state */
 
     setupGPIO();
@@ -995,7 +1381,7 @@ int dataReceivedCallback(USB_Status_TypeDef status, uint32_t xferred, uint32_t r
 
             /* Requests the state of the battery */
 
-            batteryState = AudioMoth_getBatteryState();
+            batteryState = AudioMoth_measureBatteryState();
 
             memcpy(transmitBuffer + 1, &batteryState, 1);
 
@@ -1069,17 +1455,29 @@ void AudioMoth_handleUSB(void) {
 
 }
 
-/* Function to get the battery power */
+/* Function to get the battery power, using the last measurement if it is recent */
 
 AM_batteryState_t AudioMoth_getBatteryState() {
 
-    AM_batteryState_t batteryState = AM_BATTERY_LOW;
+    uint32_t cachedState = BURTC_RetRegGet(AM_BURTC_BATTERY_STATE);
+
+    uint32_t cachedTime = BURTC_RetRegGet(AM_BURTC_BATTERY_TIME);
 
-    /* Initialise max and min voltage levels */
+    uint32_t currentTime = AudioMoth_getTime();
 
-    uint32_t minBatteryThreshold = 34;                  // 3V3 * 2 * 34 / 63 = 3.6V
+    if ((cachedState & AM_BATTERY_STATE_VALID_FLAG) && currentTime >= cachedTime && currentTime - cachedTime < AM_BATTERY_STATE_MAXIMUM_AGE) {
 
-    uint32_t maxBatteryThreshold = 48;                  // 3V3 * 2 * 48 / 63 = 5.0V
+        return (AM_batteryState_t)(cachedState & ~AM_BATTERY_STATE_VALID_FLAG);
+
+    }
+
+    return AudioMoth_measureBatteryState();
+
+}
+
+/* Function to measure the battery power and update the cached state */
+
+AM_batteryState_t AudioMoth_measureBatteryState() {
 
     /* Turn battery monitor on */
 
@@ -1089,20 +1487,30 @@ AM_batteryState_t AudioMoth_getBatteryState() {
 
     CMU_ClockEnable(cmuClock_ACMP0, true);
 
-    for (uint32_t threshold = minBatteryThreshold; threshold <= maxBatteryThreshold; threshold += 1) {
+    /* Successive approximation of the number of thresholds the battery is above, which takes four comparisons rather than up to fifteen */
+
+    uint32_t lowerCount = 0;
+
+    uint32_t upperCount = AM_BATTERY_MAX_THRESHOLD - AM_BATTERY_MIN_THRESHOLD + 1;
 
-        if (batteryIsAboveVoltageThreshold(threshold)) {
+    while (lowerCount < upperCount) {
 
-            batteryState += 1;
+        uint32_t count = (lowerCount + upperCount + 1) / 2;
+
+        if (batteryIsAboveVoltageThreshold(AM_BATTERY_MIN_THRESHOLD + count - 1)) {
+
+            lowerCount = count;
 
         } else {
 
-            break;
+            upperCount = count - 1;
 
         }
 
     }
 
+    AM_batteryState_t batteryState = (AM_batteryState_t)(AM_BATTERY_LOW + lowerCount);
+
     /* Turn Battery Monitor off*/
 
     GPIO_PinOutClear(BAT_MON_GPIOPORT, BAT_MON_EN);
@@ -1111,6 +1519,12 @@ AM_batteryState_t AudioMoth_getBatteryState() {
 
     CMU_ClockEnable(cmuClock_ACMP0, false);
 
+    /* Cache the result in the backup registers */
+
+    BURTC_RetRegSet(AM_BURTC_BATTERY_STATE, batteryState | AM_BATTERY_STATE_VALID_FLAG);
+
+    BURTC_RetRegSet(AM_BURTC_BATTERY_TIME, AudioMoth_getTime());
+
     return batteryState;
 
 }
@@ -1226,6 +1640,18 @@ uint32_t AudioMoth_getTime(void) {
 
 }
 
+/* Function to get the time and the ticks since the start of the second from a single read of the counter, which is short enough for an interrupt handler */
+
+uint32_t AudioMoth_getTimeAndTicks(uint32_t *ticks) {
+
+    uint32_t counter = BURTC_CounterGet();
+
+    *ticks = counter % AM_LFXO_TICKS_PER_SECOND;
+
+    return BURTC_RetRegGet(AM_BURTC_TIME_OFFSET) + counter / AM_LFXO_TICKS_PER_SECOND;
+
+}
+
 /* Functions to initialise, feed and query the watch dog timer */
 
 static void setupWatchdogTimer(void) {
@@ -1296,6 +1722,22 @@ void AudioMoth_setBothLED(bool state) {
 
 }
 
+static void setLED(AM_LED_t led, bool state) {
+
+    switch (led) {
+        case AM_LED_RED:
+            AudioMoth_setRedLED(state);
+            break;
+        case AM_LED_GREEN:
+            AudioMoth_setGreenLED(state);
+            break;
+        case AM_LED_BOTH:
+            AudioMoth_setBothLED(state);
+            break;
+    }
+
+}
+
 void AudioMoth_setGreenLED(bool state) {
 
     GPIO_PinModeSet(LED_GPIOPORT, GREEN_PIN, gpioModePushPull, state);
@@ -1415,6 +1857,12 @@ bool AudioMoth_seekInFile(uint32_t position) {
 
 }
 
+uint32_t AudioMoth_getFileSize(void) {
+
+    return f_size(&file);
+
+}
+
 bool AudioMoth_writeToFile(void *bytes, uint32_t bytesToWrite) {
 
     FRESULT res = f_write(&file, bytes, bytesToWrite, &bw);
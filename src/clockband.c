@@ -0,0 +1,67 @@
+/****************************************************************************
+ * clockband.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include "clockband.h"
+
+/* ADC settings in order of preference, favouring oversampling over acquisition time */
+
+static const uint32_t oversampleRates[] = {128, 64, 32, 16, 8, 4, 2};
+
+static const uint32_t acquisitionCycles[] = {16, 8, 4, 2, 1};
+
+#define NUMBER_OF_OVERSAMPLE_RATES          (sizeof(oversampleRates) / sizeof(uint32_t))
+
+#define NUMBER_OF_ACQUISITION_CYCLES        (sizeof(acquisitionCycles) / sizeof(uint32_t))
+
+bool selectClockBand(const uint32_t *bandFrequencies, uint32_t numberOfBands, uint32_t sampleRate, uint32_t clockDivider, uint32_t samplesPerBuffer, uint32_t cyclesPerBuffer, clockBandSelection_t *selection) {
+
+    for (uint32_t band = 0; band < numberOfBands; band += 1) {
+
+        uint64_t frequency = bandFrequencies[band];
+
+        /* Check the buffer can be processed in the available part of its period */
+
+        uint64_t availableCycles = frequency * samplesPerBuffer * (100 - CLOCK_BAND_SAFETY_MARGIN) / 100 / sampleRate;
+
+        if (cyclesPerBuffer > availableCycles) {
+
+            continue;
+
+        }
+
+        /* Find an ADC setting whose required clock is within the tuning range of the band */
+
+        uint64_t lowestFrequency = frequency * (100 - CLOCK_BAND_TUNING_RANGE) / 100;
+
+        uint64_t highestFrequency = frequency * (100 + CLOCK_BAND_TUNING_RANGE) / 100;
+
+        for (uint32_t i = 0; i < NUMBER_OF_OVERSAMPLE_RATES; i += 1) {
+
+            for (uint32_t j = 0; j < NUMBER_OF_ACQUISITION_CYCLES; j += 1) {
+
+                uint64_t requiredFrequency = (uint64_t)sampleRate * clockDivider * (2 + (acquisitionCycles[j] + 12) * oversampleRates[i]);
+
+                if (requiredFrequency >= lowestFrequency && requiredFrequency <= highestFrequency) {
+
+                    selection->clockBand = band;
+
+                    selection->acquisitionCycles = acquisitionCycles[j];
+
+                    selection->oversampleRate = oversampleRates[i];
+
+                    return true;
+
+                }
+
+            }
+
+        }
+
+    }
+
+    return false;
+
+}
@@ -0,0 +1,119 @@
+/****************************************************************************
+ * decimator.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <string.h>
+
+#include "decimator.h"
+
+#define PI                                  3.14159265358979f
+
+#define Q15_SCALE                           32768.0f
+
+bool initialiseDecimator(decimator_t *decimator, uint32_t factor, uint32_t blockSize) {
+
+    if (factor < 1 || factor > DECIMATOR_MAXIMUM_FACTOR || blockSize > DECIMATOR_MAXIMUM_BLOCK_SIZE || blockSize % factor != 0) return false;
+
+    uint32_t numberOfTaps = DECIMATOR_TAPS_PER_PHASE * factor;
+
+    /* Hamming windowed sinc with its cutoff at half the output sample rate */
+
+    float taps[DECIMATOR_MAXIMUM_TAPS];
+
+    float cutoff = 0.5f / factor;
+
+    float centre = (numberOfTaps - 1) / 2.0f;
+
+    float sum = 0.0f;
+
+    for (uint32_t i = 0; i < numberOfTaps; i += 1) {
+
+        float x = 2.0f * PI * cutoff * (i - centre);
+
+        float sinc = x == 0.0f ? 1.0f : sinf(x) / x;
+
+        float window = 0.54f - 0.46f * cosf(2.0f * PI * i / (numberOfTaps - 1));
+
+        taps[i] = sinc * window;
+
+        sum += taps[i];
+
+    }
+
+    /* Normalise to unity gain at DC. The filter is symmetric so the reversed order expected by CMSIS is the same */
+
+    for (uint32_t i = 0; i < numberOfTaps; i += 1) {
+
+        float coefficient = taps[i] / sum * Q15_SCALE;
+
+        decimator->coefficients[i] = coefficient >= Q15_SCALE - 1.0f ? INT16_MAX : (int16_t)(coefficient + (coefficient < 0.0f ? -0.5f : 0.5f));
+
+    }
+
+    memset(decimator->state, 0, sizeof(decimator->state));
+
+#ifdef ARM_MATH_CM4
+
+    return arm_fir_decimate_init_q15(&decimator->instance, numberOfTaps, factor, decimator->coefficients, decimator->state, blockSize) == ARM_MATH_SUCCESS;
+
+#else
+
+    decimator->factor = factor;
+
+    decimator->numberOfTaps = numberOfTaps;
+
+    return true;
+
+#endif
+
+}
+
+#ifdef ARM_MATH_CM4
+
+void decimate(decimator_t *decimator, int16_t *input, int16_t *output, uint32_t blockSize) {
+
+    arm_fir_decimate_q15(&decimator->instance, input, output, blockSize);
+
+}
+
+#else
+
+/* Portable kernel with the same arithmetic as the CMSIS q15 function, a 64-bit accumulator shifted and saturated to 16 bits */
+
+void decimate(decimator_t *decimator, int16_t *input, int16_t *output, uint32_t blockSize) {
+
+    uint32_t factor = decimator->factor;
+
+    uint32_t numberOfTaps = decimator->numberOfTaps;
+
+    /* The state holds the last numberOfTaps - 1 input samples followed by the new block */
+
+    memcpy(decimator->state + numberOfTaps - 1, input, blockSize * sizeof(int16_t));
+
+    /* As in CMSIS, output i ends with input i * factor of the block, so its window starts i * factor into the state */
+
+    for (uint32_t i = 0; i < blockSize / factor; i += 1) {
+
+        int16_t *samples = decimator->state + i * factor;
+
+        int64_t accumulator = 0;
+
+        for (uint32_t j = 0; j < numberOfTaps; j += 1) {
+
+            accumulator += (int32_t)samples[j] * decimator->coefficients[j];
+
+        }
+
+        accumulator >>= 15;
+
+        output[i] = accumulator > INT16_MAX ? INT16_MAX : accumulator < INT16_MIN ? INT16_MIN : (int16_t)accumulator;
+
+    }
+
+    memmove(decimator->state, decimator->state + blockSize, (numberOfTaps - 1) * sizeof(int16_t));
+
+}
+
+#endif
@@ -12,6 +12,13 @@
 
 #include "audioMoth.h"
 #include "detector.h"
+#include "decimator.h"
+#include "schedule.h"
+#include "profiler.h"
+#include "clockband.h"
+#include "powerpolicy.h"
+#include "ratelimiter.h"
+#include "events.h"
 
 /* Sleep and LED constants */
 
@@ -26,6 +33,9 @@
 
 #define SECONDS_IN_MINUTE                   60
 #define SECONDS_IN_HOUR                     (60 * SECONDS_IN_MINUTE)
+#define SECONDS_IN_DAY                      (24 * SECONDS_IN_HOUR)
+
+#define MILLISECONDS_IN_SECOND              1000
 
 /* 32 GB storage, 64 KB files, 333 day battery */
 /* Maximum of 1400 recordings will be produced per day */
@@ -33,42 +43,129 @@
 
 #define MAX_RECORDINGS_PER_HOUR             100
 
-/* SRAM buffer constants */
+/* Recordings are limited by a token bucket which refills at the hourly rate and allows bursts of the same size */
+
+#define RECORDING_TOKEN_CAPACITY            MAX_RECORDINGS_PER_HOUR
+#define RECORDING_TOKEN_REFILL_INTERVAL     (SECONDS_IN_HOUR / MAX_RECORDINGS_PER_HOUR)
+
+/* Sound wake constants. The device wakes from EM2 within the watchdog period, and analyses this long after each sound */
+
+#define SOUND_WAKE_CHECK_INTERVAL           16
+#define SOUND_WAKE_ANALYSIS_DURATION        10
+
+/* Number of events held in RAM before they are appended to the events file */
+
+#define EVENT_BUFFER_LENGTH                 32
+
+/* Clock band calibration constants */
+
+#define CLOCK_CALIBRATION_DETECTIONS        30
+#define CLOCK_CALIBRATION_INTERVAL          (7 * SECONDS_IN_DAY)
+#define DEFAULT_WRITE_CYCLES                4000000
+
+/* HFRCO calibration constants, with errors in hundredths of a percent */
+
+#define HFRCO_ERROR_TOLERANCE               20
+#define HFRCO_REFINEMENT_STEPS              2
+
+/* Capture rate, chosen at build time. Above the detector rate each DMA transfer is decimated to the detector rate */
+
+#ifndef CAPTURE_SAMPLE_RATE
+#define CAPTURE_SAMPLE_RATE                 DETECTOR_SAMPLE_RATE
+#endif
+
+#if CAPTURE_SAMPLE_RATE != 8000 && CAPTURE_SAMPLE_RATE != 16000 && CAPTURE_SAMPLE_RATE != 32000 && CAPTURE_SAMPLE_RATE != 48000
+#error "CAPTURE_SAMPLE_RATE must be 8000, 16000, 32000 or 48000"
+#endif
+
+#define DECIMATION_FACTOR                   (CAPTURE_SAMPLE_RATE / DETECTOR_SAMPLE_RATE)
+
+/* Default ADC settings which reach the capture rate by tuning the 11MHz HFRCO band by less than ten percent */
+
+#if DECIMATION_FACTOR == 6
+#define DEFAULT_ACQUISITION_CYCLES          16
+#define DEFAULT_OVERSAMPLE_RATE             8
+#else
+#define DEFAULT_ACQUISITION_CYCLES          8
+#define DEFAULT_OVERSAMPLE_RATE             (64 / DECIMATION_FACTOR)
+#endif
+
+/* SRAM buffer constants. At the detector rate the capture buffers are also the detection buffers. Otherwise */
+/* half the SRAM holds full rate audio for recordings and half holds the decimated two second detection buffers */
 
-#define NUMBER_OF_BUFFERS                   8
 #define EXTERNAL_SRAM_SIZE_IN_SAMPLES       (AM_EXTERNAL_SRAM_SIZE_IN_BYTES / 2)
-#define NUMBER_OF_SAMPLES_IN_BUFFER         (EXTERNAL_SRAM_SIZE_IN_SAMPLES / NUMBER_OF_BUFFERS)
-#define NUMBER_OF_SAMPLES_IN_DMA_TRANSFER   128
+#define DEFAULT_SAMPLES_IN_DMA_TRANSFER     (128 * DECIMATION_FACTOR)
 #define NUMBER_OF_BUFFERS_TO_SKIP           1
 
+#if DECIMATION_FACTOR == 1
+#define NUMBER_OF_BUFFERS                   8
+#define NUMBER_OF_DETECTION_BUFFERS         NUMBER_OF_BUFFERS
+#define CAPTURE_SIZE_IN_SAMPLES             EXTERNAL_SRAM_SIZE_IN_SAMPLES
+#else
+#define NUMBER_OF_BUFFERS                   4
+#define NUMBER_OF_DETECTION_BUFFERS         4
+#define CAPTURE_SIZE_IN_SAMPLES             (EXTERNAL_SRAM_SIZE_IN_SAMPLES - NUMBER_OF_DETECTION_BUFFERS * DETECTOR_BUFFER_SIZE)
+#endif
+
+#define NUMBER_OF_SAMPLES_IN_BUFFER         (CAPTURE_SIZE_IN_SAMPLES / NUMBER_OF_BUFFERS / DEFAULT_SAMPLES_IN_DMA_TRANSFER * DEFAULT_SAMPLES_IN_DMA_TRANSFER)
+
+#if DECIMATION_FACTOR == 1 && NUMBER_OF_SAMPLES_IN_BUFFER != DETECTOR_BUFFER_SIZE
+#error "Capture buffers must match the detector buffer size at the detector rate"
+#endif
+
+/* Detections are recorded from the pair at the detector rate, or from the completed full rate buffers */
+
+#if DECIMATION_FACTOR == 1
+#define NUMBER_OF_SAMPLES_IN_DETECTION_RECORDING (2 * DETECTOR_BUFFER_SIZE)
+#else
+#define NUMBER_OF_SAMPLES_IN_DETECTION_RECORDING ((NUMBER_OF_BUFFERS - 1) * NUMBER_OF_SAMPLES_IN_BUFFER)
+#endif
+
+/* Microphone settling constants. The DC level must stay within the threshold for the given number of DMA blocks */
+
+#define MICROPHONE_SETTLE_THRESHOLD         16
+#define MICROPHONE_SETTLE_BLOCKS            8
+
 /* WAV header constant */
 
 #define PCM_FORMAT                          1
 #define RIFF_ID_LENGTH                      4
 #define LENGTH_OF_COMMENT                   128
 
-/* USB configuration constant */
+/* Profiling constants */
 
-#define MAX_START_STOP_PERIODS              5
+#define PROFILE_FILENAME                    "PROFILE.CSV"
+#define PROFILE_LINE_LENGTH                 288
 
 /* Useful macros */
 
 #define FLASH_LED(led, duration) { \
-    AudioMoth_set ## led ## LED(true); \
-    AudioMoth_delay(duration); \
-    AudioMoth_set ## led ## LED(false); \
+    AudioMoth_startLEDPattern(AM_LED_ ## led, 1, duration, 0); \
 }
 
 #define RETURN_ON_ERROR(fn) { \
     bool success = (fn); \
     if (success != true) { \
         recordingCancelled = true; \
-        FLASH_LED(Both, LONG_LED_FLASH_DURATION) \
+        FLASH_LED(BOTH, LONG_LED_FLASH_DURATION) \
+        AudioMoth_waitForLEDPattern(); \
         return; \
     } \
 }
 
+#ifdef ENABLE_PROFILING
+
+#define WRITE_PROFILE_STATISTICS() writeProfileStatistics();
+
+#else
+
+#define WRITE_PROFILE_STATISTICS()
+
+#endif
+
 #define SAVE_SWITCH_POSITION_AND_POWER_DOWN(duration) { \
+    WRITE_PROFILE_STATISTICS() \
+    writeEvents(); \
     *previousSwitchPosition = switchPosition; \
     AudioMoth_powerDownAndWake(duration, true); \
 }
@@ -77,6 +174,8 @@
 
 #define MIN(a,b) (((a) < (b)) ? (a) : (b))
 
+#define WORD_ALIGN(x) (((x) + 3) & ~3)
+
 /* WAV header */
 
 #pragma pack(push, 1)
@@ -100,6 +199,19 @@ typedef struct {
     uint16_t bitsPerSample;
 } wavFormat_t;
 
+/* Onset of the detection which made the recording, with its sample in the recording. All zero if unknown or for scheduled recordings */
+/* A trimmed recording starts at the trim offset of the untrimmed recording, which still ends at the time in the file name */
+
+typedef struct {
+    chunk_t onst;
+    uint32_t onsetTime;
+    uint16_t onsetMilliseconds;
+    uint16_t detections;
+    uint32_t onsetSample;
+    uint32_t trimOffset;
+    uint32_t untrimmedSamples;
+} onsetChunk_t;
+
 typedef struct {
     chunk_t riff;
     char format[RIFF_ID_LENGTH];
@@ -108,6 +220,7 @@ typedef struct {
     chunk_t list;
     char info[RIFF_ID_LENGTH];
     icmt_t icmt;
+    onsetChunk_t onset;
     chunk_t data;
 } wavHeader_t;
 
@@ -121,6 +234,7 @@ static wavHeader_t wavHeader = {
     .list = {.id = "LIST", .size = RIFF_ID_LENGTH + sizeof(icmt_t)},
     .info = "INFO",
     .icmt = {.icmt.id = "ICMT", .icmt.size = LENGTH_OF_COMMENT, .comment = ""},
+    .onset = {.onst = {.id = "onst", .size = sizeof(onsetChunk_t) - sizeof(chunk_t)}, .onsetTime = 0, .onsetMilliseconds = 0, .detections = 0, .onsetSample = 0, .trimOffset = 0, .untrimmedSamples = 0},
     .data = {.id = "data", .size = 0}
 };
 
@@ -133,12 +247,27 @@ void setHeaderDetails(uint32_t sampleRate, uint32_t numberOfSamples) {
 
 }
 
+void setHeaderOnset(uint32_t onsetTime, uint16_t onsetMilliseconds, uint32_t detections, uint32_t onsetSample, uint32_t trimOffset, uint32_t untrimmedSamples) {
+
+    wavHeader.onset.onsetTime = onsetTime;
+    wavHeader.onset.onsetMilliseconds = onsetMilliseconds;
+    wavHeader.onset.detections = detections;
+    wavHeader.onset.onsetSample = onsetSample;
+    wavHeader.onset.trimOffset = trimOffset;
+    wavHeader.onset.untrimmedSamples = untrimmedSamples;
+
+}
+
 void setHeaderComment(uint32_t currentTime, uint8_t *serialNumber, uint32_t gain) {
 
     time_t rawtime = currentTime;
 
+    PROFILE_START(PROFILE_GMTIME)
+
     struct tm *time = gmtime(&rawtime);
 
+    PROFILE_STOP(PROFILE_GMTIME)
+
     char *comment = wavHeader.icmt.comment;
 
     AM_batteryState_t batteryState = AudioMoth_getBatteryState();
@@ -172,11 +301,6 @@ void setHeaderComment(uint32_t currentTime, uint8_t *serialNumber, uint32_t gain
 
 #pragma pack(push, 1)
 
-typedef struct {
-    uint16_t startMinutes;
-    uint16_t stopMinutes;
-} startStopPeriod_t;
-
 typedef struct {
     uint32_t time;
     uint8_t gain;
@@ -190,7 +314,13 @@ typedef struct {
     uint8_t enableLED;
     uint8_t activeStartStopPeriods;
     startStopPeriod_t startStopPeriods[MAX_START_STOP_PERIODS];
-    uint8_t  hourWhenMaxWritesReached;
+    uint32_t targetRetrievalTime;
+    uint32_t priorityHours;
+    uint8_t soundWakeThreshold;
+    uint16_t samplesPerDMATransfer;
+    uint8_t trimDetectionRecordings;
+    uint16_t trimPreMargin;
+    uint16_t trimPostMargin;
 } configSettings_t;
 
 #pragma pack(pop)
@@ -200,54 +330,165 @@ configSettings_t defaultConfigSettings = {
     .gain = 2,
     .clockBand = AM_HFRCO_11MHZ,
     .clockDivider = 1,
-    .acquisitionCycles = 8,
-    .oversampleRate = 64,
-    .sampleRate = 8000,
+    .acquisitionCycles = DEFAULT_ACQUISITION_CYCLES,
+    .oversampleRate = DEFAULT_OVERSAMPLE_RATE,
+    .sampleRate = CAPTURE_SAMPLE_RATE,
     .sleepDuration = 5,
     .recordDuration = 3600,
     .enableLED = 0,
-    .activeStartStopPeriods = 2,
+    .activeStartStopPeriods = 1,
     .startStopPeriods = {
         /* {.startMinutes = 780, .stopMinutes = 1380}, */ /* Start: 7:00 CST (13:00 UTC), Stop: 17:00 CST (23:00 UTC) */
-        /* Night time listening schedule */
-        {.startMinutes = 1380, .stopMinutes = 1439},   /* Start: 17:00 CST (23:00 UTC), Stop: 18:00 CST (23:59 UTC) */
-        {.startMinutes = 0, .stopMinutes = 780},  /* Start: 18:00 CST (0:00 UTC), Stop: 7:00 CST (13:00 UTC) */
+        /* Night time listening schedule, crossing midnight UTC */
+        {.startMinutes = 1380, .stopMinutes = 780},   /* Start: 17:00 CST (23:00 UTC), Stop: 7:00 CST (13:00 UTC) */
         {.startMinutes = 0, .stopMinutes = 0},
         {.startMinutes = 0, .stopMinutes = 0},
         {.startMinutes = 0, .stopMinutes = 0}
     },
-    .hourWhenMaxWritesReached = 0XFF,
+    .targetRetrievalTime = 0,
+    .priorityHours = 0x80003F,          /* 23:00 to 06:00 UTC, 17:00 to 00:00 CST */
+    .soundWakeThreshold = 0,            /* Fraction of VDD in 64ths, zero listens continuously */
+    .samplesPerDMATransfer = DEFAULT_SAMPLES_IN_DMA_TRANSFER,
+    .trimDetectionRecordings = 0,       /* Write only the detected span of each detection recording, with margins in milliseconds */
+    .trimPreMargin = 250,
+    .trimPostMargin = 500
 };
 
+/* Clock band chosen from measured processing time, stored in the backup domain */
+
+typedef struct {
+    uint32_t valid;
+    uint32_t timeOfCalibration;
+    uint32_t numberOfDetectionsMeasured;
+    uint32_t maximumDetectionCycles;
+    uint32_t maximumWriteCycles;
+    clockBandSelection_t selection;
+} clockCalibration_t;
+
+/* HFRCO tuning found by the last full calibration or refinement, stored in the backup domain */
+
+typedef struct {
+    uint32_t valid;
+    uint32_t clockBand;
+    uint32_t targetFrequency;
+    uint32_t tuning;
+    int32_t error;
+} hfrcoCalibration_t;
+
+/* Backup domain layout */
+
+#define CONFIG_SETTINGS_ADDRESS             (AM_BACKUP_DOMAIN_START_ADDRESS + 12)
+#define CLOCK_CALIBRATION_ADDRESS           WORD_ALIGN(CONFIG_SETTINGS_ADDRESS + sizeof(configSettings_t))
+#define POWER_POLICY_ADDRESS                WORD_ALIGN(CLOCK_CALIBRATION_ADDRESS + sizeof(clockCalibration_t))
+#define HFRCO_CALIBRATION_ADDRESS           WORD_ALIGN(POWER_POLICY_ADDRESS + sizeof(powerPolicyState_t))
+#define RATE_LIMITER_ADDRESS                WORD_ALIGN(HFRCO_CALIBRATION_ADDRESS + sizeof(hfrcoCalibration_t))
+
 uint32_t *previousSwitchPosition = (uint32_t*)AM_BACKUP_DOMAIN_START_ADDRESS;
 
 uint32_t *timeOfNextRecording = (uint32_t*)(AM_BACKUP_DOMAIN_START_ADDRESS + 4);
 
 uint32_t *durationOfNextRecording = (uint32_t*)(AM_BACKUP_DOMAIN_START_ADDRESS + 8);
 
-configSettings_t *configSettings = (configSettings_t*)(AM_BACKUP_DOMAIN_START_ADDRESS + 12);
+configSettings_t *configSettings = (configSettings_t*)CONFIG_SETTINGS_ADDRESS;
+
+clockCalibration_t *clockCalibration = (clockCalibration_t*)CLOCK_CALIBRATION_ADDRESS;
+
+powerPolicyState_t *powerPolicy = (powerPolicyState_t*)POWER_POLICY_ADDRESS;
+
+hfrcoCalibration_t *hfrcoCalibration = (hfrcoCalibration_t*)HFRCO_CALIBRATION_ADDRESS;
+
+rateLimiter_t *rateLimiter = (rateLimiter_t*)RATE_LIMITER_ADDRESS;
 
 /* SRAM buffer variables */
 
 static volatile uint8_t writeBuffer;
 static volatile uint32_t writeBufferIndex;
 
+/* Count of completed capture buffers since the microphone started, which places the full rate recordings in the detection stream */
+
+static volatile uint32_t completedCaptureBuffers;
+
+static uint32_t samplesPerDMATransfer = DEFAULT_SAMPLES_IN_DMA_TRANSFER;
+
 static volatile bool recordingCancelled;
 
 static int16_t* buffers[NUMBER_OF_BUFFERS];
 
+/* Detection buffer variables, which follow the capture buffers unless the capture is being decimated */
+
+static volatile uint8_t detectionWriteBuffer;
+static volatile uint32_t detectionWriteBufferIndex;
+
+static int16_t* detectionBuffers[NUMBER_OF_DETECTION_BUFFERS];
+
+/* Time latched by the DMA interrupt as each detection buffer is completed */
+
+typedef struct {
+    uint32_t time;
+    uint32_t ticks;
+} bufferTime_t;
+
+static volatile bufferTime_t detectionBufferTimes[NUMBER_OF_DETECTION_BUFFERS];
+
+/* Onset of a detection, as a time and as samples from the start of the pair and of the detection stream, and the length of the detected span */
+
+typedef struct {
+    uint32_t time;
+    uint16_t milliseconds;
+    uint32_t sampleInPair;
+    uint32_t sampleInStream;
+    uint32_t spanLength;
+} onset_t;
+
+#if DECIMATION_FACTOR > 1
+
+static volatile bool decimating;
+
+static decimator_t decimator;
+
+#endif
+
 /* Current recording file name and folder name */
 
 static char fileName[21];
 static char folderName[8];
 
+/* Events waiting to be written */
+
+static eventRecord_t events[EVENT_BUFFER_LENGTH];
+
+static uint32_t numberOfEvents;
+
+/* Detection models read from the SD card, kept for the listening session */
+
+static modelFile_t modelFile;
+
+#ifdef ENABLE_PROFILING
+
+static char profileLine[PROFILE_LINE_LENGTH];
+
+#endif
+
 /* Function prototypes */
 
 static void flashLedToIndicateBatteryLife(void);
 static void makeRecording(uint32_t currentTime, uint32_t recordDuration, bool enableLED);
-static void makeRecordingIfDetected(uint32_t currentTime, int16_t* buffer1, int16_t* buffer2, bool enableLED);
-static bool inListeningPeriod(uint32_t currentTime);
-static void initMicrophone(void);
+static void makeRecordingIfDetected(uint32_t currentTime, int16_t* buffer1, int16_t* buffer2, uint32_t detections, const onset_t *onset, bool enableLED);
+static void writeBufferInRange(int16_t *buffer, uint32_t bufferStart, uint32_t bufferLength, uint32_t start, uint32_t end);
+static void initMicrophone(uint32_t clockBand, uint32_t acquisitionCycles, uint32_t oversampleRate, bool listening);
+static void selectClockBandFromMeasurements(uint32_t currentTime);
+static void calibrateHFRCO(uint32_t clockBand, uint32_t targetFrequency);
+static uint32_t waitForMicrophoneToSettle(void);
+static void getOnset(uint32_t referenceBuffer, uint32_t referenceSample, uint32_t pairStartSample, onset_t *onset);
+static void logEvent(uint32_t currentTime, uint8_t flags, uint32_t detections, const onset_t *onset);
+static void writeEvents(void);
+static void loadModelFile(void);
+
+#ifdef ENABLE_PROFILING
+
+static void writeProfileStatistics(void);
+
+#endif
 
 /* Main function */
 
@@ -257,8 +498,20 @@ static void initMicrophone(void);
 
     AudioMoth_initialise();
 
+    PROFILE_INITIALISE()
+
     AM_switchPosition_t switchPosition = AudioMoth_getSwitchPosition();
 
+    /* A fast resume leaves the HFXO off, which everything but listening still needs */
+
+    if (AudioMoth_isFastResume() && switchPosition != AM_SWITCH_CUSTOM) {
+
+        AudioMoth_enableHFXO();
+
+        AudioMoth_selectHFXO();
+
+    }
+
     if (AudioMoth_isInitialPowerUp()) {
 
         *timeOfNextRecording = 0;
@@ -269,6 +522,14 @@ static void initMicrophone(void);
 
         memcpy(configSettings, &defaultConfigSettings, sizeof(configSettings_t));
 
+        memset(clockCalibration, 0, sizeof(clockCalibration_t));
+
+        initialisePowerPolicy(powerPolicy);
+
+        memset(hfrcoCalibration, 0, sizeof(hfrcoCalibration_t));
+
+        initialiseRateLimiter(rateLimiter, RECORDING_TOKEN_CAPACITY, AudioMoth_getTime());
+
     } else {
 
         /* Indicate battery state is not initial power up and switch has been moved into USB */
@@ -295,7 +556,7 @@ static void initMicrophone(void);
 
     if (switchPosition == AM_SWITCH_CUSTOM && (AudioMoth_hasTimeBeenSet() == false || configSettings->activeStartStopPeriods == 0)) {
 
-        FLASH_LED(Both, SHORT_LED_FLASH_DURATION)
+        FLASH_LED(BOTH, SHORT_LED_FLASH_DURATION)
 
         SAVE_SWITCH_POSITION_AND_POWER_DOWN(DEFAULT_WAIT_INTERVAL);
 
@@ -327,7 +588,7 @@ static void initMicrophone(void);
 
         /* Setup Microphone */
 
-        initMicrophone();
+        initMicrophone(configSettings->clockBand, configSettings->acquisitionCycles, configSettings->oversampleRate, false);
 
         makeRecording(currentTime, *durationOfNextRecording, enableLED);
 
@@ -341,387 +602,887 @@ static void initMicrophone(void);
 
     }
 
-    /* Handle the case that the switch is in CUSTOM position */
+    /* Calculate the current or next listening window once, so the detection loop only needs to compare against its stop time */
 
-    if (switchPosition == AM_SWITCH_CUSTOM && inListeningPeriod(currentTime)) {
+    uint32_t listeningStartTime = 0;
 
-        time_t rawtime = currentTime;
+    uint32_t listeningStopTime = 0;
 
-        struct tm *time = gmtime(&rawtime);
+    bool listeningScheduled = switchPosition == AM_SWITCH_CUSTOM && calculateListeningWindow(configSettings->startStopPeriods, configSettings->activeStartStopPeriods, currentTime, &listeningStartTime, &listeningStopTime);
 
-        /* Check that the max number of writes has happened in the current hour, sleep if max has been reached */
+    bool inListeningWindow = listeningScheduled && currentTime >= listeningStartTime;
 
-        if (configSettings->hourWhenMaxWritesReached == time->tm_hour) {
+    /* Measure the battery at low frequency and let the policy decide how much of the window to listen to */
 
-            /* Flash LED to indicate waiting */
+    if (inListeningWindow && isPowerPolicyUpdateDue(powerPolicy, currentTime)) {
 
-            if(configSettings->enableLED){
+        updatePowerPolicy(powerPolicy, currentTime, AudioMoth_getBatteryState(), configSettings->targetRetrievalTime);
 
-                FLASH_LED(Green, SHORT_LED_FLASH_DURATION)
+    }
 
-            }
+    bool hourAllowed = powerPolicyAllowsHour(powerPolicy->level, configSettings->priorityHours, (currentTime % SECONDS_IN_DAY) / SECONDS_IN_HOUR);
 
-            SAVE_SWITCH_POSITION_AND_POWER_DOWN(configSettings->sleepDuration);
+    /* Handle the case that the switch is in CUSTOM position */
 
-        }
+    if (inListeningWindow && hourAllowed) {
 
-        /* Setup Microphone */
+        /* Read any replacement detection models before waiting for sound, so the card is not touched between a trigger and the */
+        /* microphone starting. A fast resume reads them while the microphone settles instead */
 
-        initMicrophone();
+        bool modelsLoaded = !AudioMoth_isFastResume() || configSettings->soundWakeThreshold > 0;
 
-        /* Number of files written in the current hour */
+        if (modelsLoaded) {
 
-        uint16_t filesWritten = 0;
+            loadModelFile();
 
-        /* Hour when loop previously ran. If different to current hour then the recording count is reset */
+        }
 
-        uint8_t triggerHour = 0;
-        uint8_t prevHour = 0;
+        /* In sound wake mode wait in EM2 for the comparator to see a loud sound, then analyse the following seconds */
 
-        /* Set up buffers for detection */
+        uint32_t sessionStopTime = listeningStopTime;
 
-        uint32_t readBuffer = 0;
-        uint32_t prevreadBuffer = 0;
+        if (configSettings->soundWakeThreshold > 0) {
+
+            AudioMoth_enableSoundWake(configSettings->gain, configSettings->soundWakeThreshold);
+
+            bool soundDetected = false;
 
-        /* Skip first buffer to remove microphone ramp up, only happens at the start of each day or max out hour */
+            while (!soundDetected && !recordingCancelled && currentTime < listeningStopTime) {
 
-        while (writeBuffer != 3);
+                soundDetected = AudioMoth_sleepUntilSound(MIN(SOUND_WAKE_CHECK_INTERVAL, listeningStopTime - currentTime));
 
-        /* Read buffers are the two buffers preceding the current write buffer */
+                AudioMoth_feedWatchdog();
 
-        readBuffer = writeBuffer - 1;
-        prevreadBuffer = readBuffer - 1;
+                currentTime = AudioMoth_getTime();
 
-        while (!recordingCancelled && inListeningPeriod(currentTime)) {
+            }
 
-            /* If the hour has changed since last iteration of the loop, reset the recording counter */
+            AudioMoth_disableSoundWake();
 
-            if (prevHour != time->tm_hour) {
+            if (!soundDetected) {
 
-                filesWritten = 0;
+                SAVE_SWITCH_POSITION_AND_POWER_DOWN(DEFAULT_WAIT_INTERVAL);
 
             }
 
-            prevHour = time->tm_hour;
+            sessionStopTime = MIN(listeningStopTime, currentTime + SOUND_WAKE_ANALYSIS_DURATION);
 
-            while (readBuffer != writeBuffer && !recordingCancelled) {
+        }
 
-                /* Run gunshot detection, making a recording if response is positive */
+        /* Measure processing time at the configured clock band if the selected band is missing or due to be checked */
 
-                bool containsGunshot = detected(buffers[prevreadBuffer], buffers[readBuffer]);
+        bool calibratingClockBand = configSettings->clockBand < AM_HFXO && (!clockCalibration->valid || currentTime - clockCalibration->timeOfCalibration >= CLOCK_CALIBRATION_INTERVAL);
 
-                if (containsGunshot) {
+        enableProfileCounter();
 
-                    triggerHour = (uint8_t) time->tm_hour;
+        /* Setup Microphone */
 
-                    makeRecordingIfDetected(currentTime, buffers[prevreadBuffer], buffers[readBuffer], configSettings->enableLED);
+        if (calibratingClockBand || !clockCalibration->valid) {
 
-                    filesWritten++;
+            initMicrophone(configSettings->clockBand, configSettings->acquisitionCycles, configSettings->oversampleRate, true);
 
-                }
+        } else {
 
-                /* Check current hourly recording count */
+            initMicrophone(clockCalibration->selection.clockBand, clockCalibration->selection.acquisitionCycles, clockCalibration->selection.oversampleRate, true);
 
-                if (filesWritten >= MAX_RECORDINGS_PER_HOUR) {
+        }
 
-                    configSettings->hourWhenMaxWritesReached = triggerHour;
+        /* Start of the next hour, at which statistics are written and the battery policy is checked */
 
-                    /* Flash LED to indicate waiting */
+        uint32_t nextHourTime = currentTime - currentTime % SECONDS_IN_HOUR + SECONDS_IN_HOUR;
 
-                    if (configSettings->enableLED) {
+        bool alternatePairs = powerPolicyAnalysesAlternatePairs(powerPolicy->level);
 
-                        FLASH_LED(Green, SHORT_LED_FLASH_DURATION)
+        /* Set up buffers for detection */
 
-                    }
+        uint32_t readBuffer = 0;
+        uint32_t prevreadBuffer = 0;
 
-                    /* Power down */
+        /* Skip the microphone ramp up, then wait for the first pair of buffers after it. The detection buffers are contiguous so this pair can start part way through the first buffer */
 
-                    SAVE_SWITCH_POSITION_AND_POWER_DOWN(configSettings->sleepDuration);
+        uint32_t settledIndex = waitForMicrophoneToSettle() / DECIMATION_FACTOR;
 
-                } else {
+        int16_t *firstPair = detectionBuffers[0] + settledIndex;
 
-                    /* If not at max recordings, reset value which is checked upon wakeup */
+        if (!modelsLoaded) {
 
-                    configSettings->hourWhenMaxWritesReached = 0XFF;
+            loadModelFile();
 
-                }
+        }
 
-                /* Increment buffer counters */
+        while (detectionWriteBuffer * DETECTOR_BUFFER_SIZE + detectionWriteBufferIndex < settledIndex + 2 * DETECTOR_BUFFER_SIZE) {
 
-                prevreadBuffer = readBuffer;
+            AudioMoth_sleep();
 
-                readBuffer = (readBuffer + 1) & (NUMBER_OF_BUFFERS - 1);
+        }
 
-                /* Update Time*/
+        if (!AudioMoth_isInitialPowerUp()) {
 
-                currentTime = AudioMoth_getTime();
+            PROFILE_RECORD(PROFILE_BOOT_TO_FIRST_SAMPLE, AudioMoth_getMillisecondsSinceWake())
 
-                /* Check that the time is still within the listening schedule */
+        }
 
-                if (!inListeningPeriod(currentTime)) {
+        /* Count of wakes from EM1 between buffers, which depends on the DMA transfer size */
 
-                    break;
+        uint32_t wakesSinceLastBuffer = 0;
 
-                }
+        /* Subsequent pairs follow on from the buffer in which the first pair ends */
 
-                /* Feed the watch dog Timer */
+        readBuffer = 2;
+        prevreadBuffer = 1;
 
-                AudioMoth_feedWatchdog();
+        /* Index of prevreadBuffer in the detection stream, counting every buffer since the first, which places each pair in the stream */
 
-            }
+        uint32_t prevreadBufferInStream = 1;
 
-            /* Sleep until next DMA transfer is complete */
+        while (!recordingCancelled && currentTime < sessionStopTime) {
 
-            AudioMoth_sleep();
+            /* If the hour has changed since last iteration of the loop, write out statistics and events */
 
-        }
+            if (currentTime >= nextHourTime) {
 
-    }
+                WRITE_PROFILE_STATISTICS()
 
-    /* Flash LED to indicate waiting */
+                writeEvents();
 
-    if (configSettings->enableLED) {
+                nextHourTime = currentTime - currentTime % SECONDS_IN_HOUR + SECONDS_IN_HOUR;
 
-        FLASH_LED(Green, SHORT_LED_FLASH_DURATION)
+                /* Apply any change in the battery policy, stopping if this hour is no longer a priority */
 
-    }
+                if (isPowerPolicyUpdateDue(powerPolicy, currentTime)) {
 
-    /* Power down */
+                    updatePowerPolicy(powerPolicy, currentTime, AudioMoth_getBatteryState(), configSettings->targetRetrievalTime);
 
-    SAVE_SWITCH_POSITION_AND_POWER_DOWN(configSettings->sleepDuration);
+                    alternatePairs = powerPolicyAnalysesAlternatePairs(powerPolicy->level);
 
-}
+                }
 
-/* AudioMoth handlers */
+                hourAllowed = powerPolicyAllowsHour(powerPolicy->level, configSettings->priorityHours, (currentTime % SECONDS_IN_DAY) / SECONDS_IN_HOUR);
 
-inline void AudioMoth_handleSwitchInterrupt() {
+                if (!hourAllowed) {
 
-    recordingCancelled = true;
+                    break;
 
-}
+                }
 
-inline void AudioMoth_handleMicrophoneInterrupt(int16_t sample) { }
+            }
 
-inline void AudioMoth_handleDirectMemoryAccessInterrupt(bool isPrimaryBuffer, int16_t **nextBuffer) {
+            while ((readBuffer != detectionWriteBuffer || firstPair != NULL) && !recordingCancelled) {
 
-    /* Update the current buffer index and write buffer */
+                int16_t *pairBuffer1 = firstPair == NULL ? detectionBuffers[prevreadBuffer] : firstPair;
 
-    writeBufferIndex += NUMBER_OF_SAMPLES_IN_DMA_TRANSFER;
+                int16_t *pairBuffer2 = firstPair == NULL ? detectionBuffers[readBuffer] : firstPair + DETECTOR_BUFFER_SIZE;
 
-    if (writeBufferIndex == NUMBER_OF_SAMPLES_IN_BUFFER) {
+                /* When the battery policy requires it, only analyse the non-overlapping pairs starting on an even buffer */
 
-        writeBufferIndex = 0;
+                bool analysePair = firstPair != NULL || !alternatePairs || (prevreadBuffer & 1) == 0;
 
-        writeBuffer = (writeBuffer + 1) & (NUMBER_OF_BUFFERS - 1);
+                /* Run every detection model, making a recording if any of them responds */
 
-    }
+                uint32_t detections = 0;
 
-    /* Update the next buffer index and write buffer */
+                uint32_t detectionCycles = 0;
 
-    int nextWriteBuffer = writeBuffer;
+                if (analysePair) {
 
-    int nextWriteBufferIndex = writeBufferIndex + NUMBER_OF_SAMPLES_IN_DMA_TRANSFER;
+                    PROFILE_START(PROFILE_DETECTION)
 
-    if (nextWriteBufferIndex == NUMBER_OF_SAMPLES_IN_BUFFER) {
+                    uint32_t detectionStartCount = getProfileCount();
 
-        nextWriteBufferIndex = 0;
+                    detections = detected(pairBuffer1, pairBuffer2);
 
-        nextWriteBuffer = (nextWriteBuffer + 1) & (NUMBER_OF_BUFFERS - 1);
+                    detectionCycles = getProfileCount() - detectionStartCount;
 
-    }
+                    PROFILE_STOP(PROFILE_DETECTION)
 
-    /* Re-activate the DMA */
+                }
 
-    *nextBuffer = buffers[nextWriteBuffer] + nextWriteBufferIndex;
+                /* Time the onset from the time latched at the end of the first buffer of the pair, or of buffer one for the first pair */
 
-}
+                onset_t onset = {0};
 
-/* Initialise audio circuitry */
+                if (detections != 0) {
 
-static void initMicrophone(void) {
+                    uint32_t referenceSample = (prevreadBufferInStream + 1) * DETECTOR_BUFFER_SIZE;
 
-    /* Initialise buffers */
+                    uint32_t pairStartSample = firstPair == NULL ? prevreadBufferInStream * DETECTOR_BUFFER_SIZE : settledIndex;
 
-    writeBuffer = 0;
+                    getOnset(prevreadBuffer, referenceSample, pairStartSample, &onset);
 
-    writeBufferIndex = 0;
+                }
 
-    recordingCancelled = false;
+                /* Record the detection if a token is available, and log which models responded */
 
-    /* Initialise microphone for recording or listening */
+                if (detections != 0 && takeRateLimiterToken(rateLimiter, RECORDING_TOKEN_CAPACITY, RECORDING_TOKEN_REFILL_INTERVAL, currentTime)) {
 
-    buffers[0] = (int16_t*)AM_EXTERNAL_SRAM_START_ADDRESS;
+                    uint32_t writeStartCount = getProfileCount();
 
-    for (int i = 1; i < NUMBER_OF_BUFFERS; i += 1) {
+                    makeRecordingIfDetected(currentTime, pairBuffer1, pairBuffer2, detections, &onset, configSettings->enableLED);
 
-        buffers[i] = buffers[i - 1] + NUMBER_OF_SAMPLES_IN_BUFFER;
+                    clockCalibration->maximumWriteCycles = MAX(clockCalibration->maximumWriteCycles, getProfileCount() - writeStartCount);
 
-    }
+                    logEvent(currentTime, 0, detections, &onset);
 
-    /* Switch to HFRCO */
+                } else if (detections != 0) {
 
-    if (configSettings->clockBand < AM_HFXO) {
+                    logEvent(currentTime, EVENT_FLAG_LOG_ONLY, detections, &onset);
 
-        AudioMoth_enableHFRCO(configSettings->clockBand);
+                }
 
-        uint32_t clockFrequency = AudioMoth_getClockFrequency(configSettings->clockBand);
+                /* Track the worst case detection time and choose a clock band once enough have been measured */
 
-        uint32_t actualSampleRate = AudioMoth_calculateSampleRate(clockFrequency, configSettings->clockDivider, configSettings->acquisitionCycles, configSettings->oversampleRate);
+                if (calibratingClockBand && analysePair) {
 
-        uint32_t targetFrequency = (float)clockFrequency * (float)configSettings->sampleRate / (float)actualSampleRate;
+                    clockCalibration->maximumDetectionCycles = MAX(clockCalibration->maximumDetectionCycles, detectionCycles);
 
-        AudioMoth_calibrateHFRCO(targetFrequency);
+                    clockCalibration->numberOfDetectionsMeasured += 1;
 
-        AudioMoth_selectHFRCO();
+                    if (clockCalibration->numberOfDetectionsMeasured >= CLOCK_CALIBRATION_DETECTIONS) {
 
-    }
+                        selectClockBandFromMeasurements(currentTime);
 
-    /* Initialise microphone for recording */
+                        calibratingClockBand = false;
 
-    AudioMoth_enableExternalSRAM();
+                    }
 
-    AudioMoth_enableMicrophone(configSettings->gain, configSettings->clockDivider, configSettings->acquisitionCycles, configSettings->oversampleRate);
+                }
 
-    AudioMoth_initialiseDirectMemoryAccess(buffers[0], buffers[0] + NUMBER_OF_SAMPLES_IN_DMA_TRANSFER, NUMBER_OF_SAMPLES_IN_DMA_TRANSFER);
+                /* Increment buffer counters */
 
-    AudioMoth_startMicrophoneSamples();
+                if (firstPair == NULL) {
 
-}
+                    PROFILE_RECORD(PROFILE_WAKES_PER_BUFFER, wakesSinceLastBuffer)
 
-/* Save recording to SD card after listen*/
+                }
 
-static void makeRecordingIfDetected(uint32_t currentTime, int16_t* buffer1, int16_t* buffer2, bool enableLED) {
+                wakesSinceLastBuffer = 0;
 
-    /* Initialise file system and open a new file */
+                firstPair = NULL;
 
-    RETURN_ON_ERROR(AudioMoth_enableFileSystem());
+                prevreadBufferInStream += 1;
 
-    /* Open a file with the name as a UNIX time stamp in HEX */
+                prevreadBuffer = readBuffer;
 
-    time_t rawtime = currentTime;
+                readBuffer = (readBuffer + 1) & (NUMBER_OF_DETECTION_BUFFERS - 1);
 
-    struct tm *time = gmtime(&rawtime);
+                /* Update Time*/
 
-    /* Create a folder for current month */
+                currentTime = AudioMoth_getTime();
 
-    sprintf(folderName, "%02d_%04d", 1 + time->tm_mon, 1900 + time->tm_year);
+                /* Check that the time is still within the listening window */
 
-    sprintf(fileName, "%s\\%08X.WAV", folderName, (unsigned int)currentTime);
+                if (currentTime >= sessionStopTime) {
 
-    if (!AudioMoth_folderExists(folderName)) {
+                    break;
 
-        RETURN_ON_ERROR(AudioMoth_makeSDfolder(folderName));
+                }
 
-        RETURN_ON_ERROR(AudioMoth_openFile(fileName));
+                /* Feed the watch dog Timer */
 
-    }
+                AudioMoth_feedWatchdog();
 
-    RETURN_ON_ERROR(AudioMoth_openFile(fileName));
+            }
 
-    /* Initialise the WAV header */
+            /* Sleep until next DMA transfer is complete */
 
-    setHeaderDetails(configSettings->sampleRate, (NUMBER_OF_SAMPLES_IN_BUFFER*2));
+            AudioMoth_sleep();
 
-    setHeaderComment(currentTime, (uint8_t*)AM_UNIQUE_ID_START_ADDRESS, configSettings->gain);
+            wakesSinceLastBuffer += 1;
 
-    /* Write the file to SD card */
+        }
 
-    if (enableLED) {
+        /* Calculate the next listening window now the current one has ended */
 
-        AudioMoth_setRedLED(true);
+        listeningScheduled = calculateListeningWindow(configSettings->startStopPeriods, configSettings->activeStartStopPeriods, currentTime, &listeningStartTime, &listeningStopTime);
 
     }
 
-    AudioMoth_seekInFile(0);
+    /* Flash LED to indicate waiting */
 
-    AudioMoth_writeToFile(&wavHeader, sizeof(wavHeader));
+    if (configSettings->enableLED) {
 
-    AudioMoth_writeToFile(buffer1, 2 * NUMBER_OF_SAMPLES_IN_BUFFER);
+        FLASH_LED(GREEN, SHORT_LED_FLASH_DURATION)
 
-    AudioMoth_writeToFile(buffer2, 2 * NUMBER_OF_SAMPLES_IN_BUFFER);
+    }
 
-    AudioMoth_setRedLED(false);
+    /* Power down, waking exactly at the start of the next listening window or permitted hour if it comes before the sleep duration has elapsed */
 
-    /* Close the file */
+    uint32_t sleepDuration = configSettings->sleepDuration;
 
-    AudioMoth_closeFile();
+    if (listeningScheduled && listeningStartTime > currentTime) {
 
-    AudioMoth_disableFileSystem();
+        sleepDuration = MIN(sleepDuration, listeningStartTime - currentTime);
 
-}
+        /* Waking at the start of the window can skip starting the HFXO */
+
+        if (sleepDuration == listeningStartTime - currentTime) {
 
-static bool inListeningPeriod(uint32_t currentTime) {
+            AudioMoth_requestFastResume();
 
-    /* Check number of active state stop periods */
+        }
 
-    if (configSettings->activeStartStopPeriods > MAX_START_STOP_PERIODS) {
+    } else if (listeningScheduled && !hourAllowed) {
 
-        configSettings->activeStartStopPeriods = MAX_START_STOP_PERIODS;
+        sleepDuration = MIN(sleepDuration, SECONDS_IN_HOUR - currentTime % SECONDS_IN_HOUR);
 
     }
 
-    /* No active periods */
+    SAVE_SWITCH_POSITION_AND_POWER_DOWN(sleepDuration);
 
-    if (configSettings->activeStartStopPeriods == 0) {
+}
 
-        return false;
+/* AudioMoth handlers */
 
-    }
+inline void AudioMoth_handleSwitchInterrupt() {
 
-    /* Calculate the number of seconds of this day */
+    recordingCancelled = true;
 
-    time_t rawtime = currentTime;
+}
 
-    struct tm *time = gmtime(&rawtime);
+inline void AudioMoth_handleMicrophoneInterrupt(int16_t sample) { }
+
+inline void AudioMoth_handleDirectMemoryAccessInterrupt(bool isPrimaryBuffer, int16_t **nextBuffer) {
 
-    uint32_t currentSeconds = SECONDS_IN_HOUR * time->tm_hour + SECONDS_IN_MINUTE * time->tm_min + time->tm_sec;
+    /* Decimate the completed transfer into the detection buffers */
 
-    /* Check each active start stop period */
+#if DECIMATION_FACTOR > 1
 
-    for (uint32_t i = 0; i < configSettings->activeStartStopPeriods; i += 1) {
+    if (decimating) {
 
-        startStopPeriod_t *period = configSettings->startStopPeriods + i;
+        decimate(&decimator, buffers[writeBuffer] + writeBufferIndex, detectionBuffers[detectionWriteBuffer] + detectionWriteBufferIndex, samplesPerDMATransfer);
 
-        /* Calculate the start and stop time of the current period */
+        detectionWriteBufferIndex += samplesPerDMATransfer / DECIMATION_FACTOR;
 
-        uint32_t startSeconds = SECONDS_IN_MINUTE * period->startMinutes;
+        if (detectionWriteBufferIndex == DETECTOR_BUFFER_SIZE) {
 
-        uint32_t stopSeconds = SECONDS_IN_MINUTE * period->stopMinutes;
+            uint32_t ticks;
 
-        /* If current time inside selected period */
+            detectionBufferTimes[detectionWriteBuffer].time = AudioMoth_getTimeAndTicks(&ticks);
 
-        if (currentSeconds > startSeconds && currentSeconds < stopSeconds) {
+            detectionBufferTimes[detectionWriteBuffer].ticks = ticks;
 
-            return true;
+            detectionWriteBufferIndex = 0;
+
+            detectionWriteBuffer = (detectionWriteBuffer + 1) & (NUMBER_OF_DETECTION_BUFFERS - 1);
 
         }
 
     }
 
-    return false;
+#endif
 
-}
+    /* Update the current buffer index and write buffer */
 
-/* Save recording to SD card */
+    writeBufferIndex += samplesPerDMATransfer;
 
-static void makeRecording(uint32_t currentTime, uint32_t recordDuration, bool enableLED) {
+    if (writeBufferIndex == NUMBER_OF_SAMPLES_IN_BUFFER) {
 
-    /* Calculate recording parameters */
+#if DECIMATION_FACTOR == 1
 
-    uint32_t numberOfSamplesInHeader = sizeof(wavHeader) >> 1;
+        uint32_t ticks;
 
-    uint32_t numberOfSamples = configSettings->sampleRate * recordDuration;
+        detectionBufferTimes[writeBuffer].time = AudioMoth_getTimeAndTicks(&ticks);
 
-    /* Initialise file system and open a new file */
+        detectionBufferTimes[writeBuffer].ticks = ticks;
 
-    RETURN_ON_ERROR(AudioMoth_enableFileSystem());
+#endif
 
-    /* Open a file with the name as a UNIX time stamp in HEX */
+        writeBufferIndex = 0;
+
+        writeBuffer = (writeBuffer + 1) & (NUMBER_OF_BUFFERS - 1);
+
+        completedCaptureBuffers += 1;
+
+    }
+
+    /* Update the next buffer index and write buffer */
+
+    int nextWriteBuffer = writeBuffer;
+
+    int nextWriteBufferIndex = writeBufferIndex + samplesPerDMATransfer;
+
+    if (nextWriteBufferIndex == NUMBER_OF_SAMPLES_IN_BUFFER) {
+
+        nextWriteBufferIndex = 0;
+
+        nextWriteBuffer = (nextWriteBuffer + 1) & (NUMBER_OF_BUFFERS - 1);
+
+    }
+
+#if DECIMATION_FACTOR == 1
+
+    detectionWriteBuffer = writeBuffer;
+
+    detectionWriteBufferIndex = writeBufferIndex;
+
+#endif
+
+    /* Re-activate the DMA */
+
+    *nextBuffer = buffers[nextWriteBuffer] + nextWriteBufferIndex;
+
+}
+
+/* Initialise audio circuitry */
+
+static void initMicrophone(uint32_t clockBand, uint32_t acquisitionCycles, uint32_t oversampleRate, bool listening) {
+
+    /* Each buffer must be a whole number of DMA transfers, each decimating to a whole number of detection samples, otherwise use the default transfer size */
+
+    samplesPerDMATransfer = configSettings->samplesPerDMATransfer;
+
+    if (samplesPerDMATransfer == 0 || samplesPerDMATransfer > AM_MAX_SAMPLES_IN_DMA_TRANSFER || NUMBER_OF_SAMPLES_IN_BUFFER % samplesPerDMATransfer != 0 || samplesPerDMATransfer % DECIMATION_FACTOR != 0 || DETECTOR_BUFFER_SIZE % (samplesPerDMATransfer / DECIMATION_FACTOR) != 0) {
+
+        samplesPerDMATransfer = DEFAULT_SAMPLES_IN_DMA_TRANSFER;
+
+    }
+
+    /* Initialise buffers */
+
+    writeBuffer = 0;
+
+    writeBufferIndex = 0;
+
+    completedCaptureBuffers = 0;
+
+    detectionWriteBuffer = 0;
+
+    detectionWriteBufferIndex = 0;
+
+    recordingCancelled = false;
+
+    /* Initialise microphone for recording or listening */
+
+    buffers[0] = (int16_t*)AM_EXTERNAL_SRAM_START_ADDRESS;
+
+    for (int i = 1; i < NUMBER_OF_BUFFERS; i += 1) {
+
+        buffers[i] = buffers[i - 1] + NUMBER_OF_SAMPLES_IN_BUFFER;
+
+    }
+
+    /* Listening at a higher capture rate decimates into the detection buffers after the capture buffers */
+
+#if DECIMATION_FACTOR == 1
+
+    for (int i = 0; i < NUMBER_OF_DETECTION_BUFFERS; i += 1) {
+
+        detectionBuffers[i] = buffers[i];
+
+    }
+
+#else
+
+    detectionBuffers[0] = (int16_t*)AM_EXTERNAL_SRAM_START_ADDRESS + CAPTURE_SIZE_IN_SAMPLES;
+
+    for (int i = 1; i < NUMBER_OF_DETECTION_BUFFERS; i += 1) {
+
+        detectionBuffers[i] = detectionBuffers[i - 1] + DETECTOR_BUFFER_SIZE;
+
+    }
+
+    decimating = listening && initialiseDecimator(&decimator, DECIMATION_FACTOR, samplesPerDMATransfer);
+
+#endif
+
+    /* Listening always captures at the build time rate, which the detection buffers depend on */
+
+    uint32_t sampleRate = listening ? CAPTURE_SAMPLE_RATE : configSettings->sampleRate;
+
+    /* Switch to HFRCO */
+
+    if (clockBand < AM_HFXO) {
+
+        AudioMoth_enableHFRCO(clockBand);
+
+        uint32_t clockFrequency = AudioMoth_getClockFrequency(clockBand);
+
+        uint32_t actualSampleRate = AudioMoth_calculateSampleRate(clockFrequency, configSettings->clockDivider, acquisitionCycles, oversampleRate);
+
+        uint32_t targetFrequency = (float)clockFrequency * (float)sampleRate / (float)actualSampleRate;
+
+        calibrateHFRCO(clockBand, targetFrequency);
+
+        AudioMoth_selectHFRCO();
+
+    }
+
+    /* Initialise microphone for recording */
+
+    AudioMoth_enableExternalSRAM();
+
+    AudioMoth_enableMicrophone(configSettings->gain, configSettings->clockDivider, acquisitionCycles, oversampleRate);
+
+    AudioMoth_initialiseDirectMemoryAccess(buffers[0], buffers[0] + samplesPerDMATransfer, samplesPerDMATransfer);
+
+    AudioMoth_startMicrophoneSamples();
+
+}
+
+/* Start from the stored HFRCO tuning, refining it only if it has drifted, and falling back to a full search */
+
+static void calibrateHFRCO(uint32_t clockBand, uint32_t targetFrequency) {
+
+    bool stored = hfrcoCalibration->valid && hfrcoCalibration->clockBand == clockBand && hfrcoCalibration->targetFrequency == targetFrequency;
+
+    /* Without the HFXO there is no reference to measure against, so a fast resume trusts the stored tuning */
+
+    if (AudioMoth_isFastResume()) {
+
+        if (stored) {
+
+            AudioMoth_setHFRCOTuning(hfrcoCalibration->tuning);
+
+            return;
+
+        }
+
+        AudioMoth_enableHFXO();
+
+        AudioMoth_selectHFXO();
+
+    }
+
+    int32_t error = HFRCO_ERROR_TOLERANCE + 1;
+
+    if (stored) {
+
+        AudioMoth_setHFRCOTuning(hfrcoCalibration->tuning);
+
+        error = AudioMoth_measureHFRCOError(targetFrequency);
+
+        if (error > HFRCO_ERROR_TOLERANCE || error < -HFRCO_ERROR_TOLERANCE) {
+
+            error = AudioMoth_refineHFRCO(targetFrequency, HFRCO_REFINEMENT_STEPS);
+
+        }
+
+    }
+
+    if (error > HFRCO_ERROR_TOLERANCE || error < -HFRCO_ERROR_TOLERANCE) {
+
+        AudioMoth_calibrateHFRCO(targetFrequency);
+
+        error = AudioMoth_measureHFRCOError(targetFrequency);
+
+    }
+
+    hfrcoCalibration->valid = true;
+
+    hfrcoCalibration->clockBand = clockBand;
+
+    hfrcoCalibration->targetFrequency = targetFrequency;
+
+    hfrcoCalibration->tuning = AudioMoth_getHFRCOTuning();
+
+    hfrcoCalibration->error = error;
+
+}
+
+/* Wait until the mean of each DMA block stops changing, returning the index of the first settled sample in the SRAM buffers */
+
+static uint32_t waitForMicrophoneToSettle(void) {
+
+    uint32_t block = 0;
+
+    uint32_t stableBlocks = 0;
+
+    int32_t previousMean = 0;
+
+    /* Settling is never longer than the single buffer which was previously skipped */
+
+    while (block < NUMBER_OF_SAMPLES_IN_BUFFER / samplesPerDMATransfer && stableBlocks < MICROPHONE_SETTLE_BLOCKS) {
+
+        while (writeBuffer * NUMBER_OF_SAMPLES_IN_BUFFER + writeBufferIndex < (block + 1) * samplesPerDMATransfer) {
+
+            AudioMoth_sleep();
+
+        }
+
+        int16_t *samples = buffers[0] + block * samplesPerDMATransfer;
+
+        int32_t sum = 0;
+
+        for (uint32_t i = 0; i < samplesPerDMATransfer; i += 1) {
+
+            sum += samples[i];
+
+        }
+
+        int32_t mean = sum / samplesPerDMATransfer;
+
+        int32_t change = mean - previousMean;
+
+        if (block > 0 && change <= MICROPHONE_SETTLE_THRESHOLD && change >= -MICROPHONE_SETTLE_THRESHOLD) {
+
+            stableBlocks += 1;
+
+        } else {
+
+            stableBlocks = 0;
+
+        }
+
+        previousMean = mean;
+
+        block += 1;
+
+    }
+
+    return block * samplesPerDMATransfer;
+
+}
+
+/* Choose the lowest sufficient clock band from the worst case detection and write times */
+
+static void selectClockBandFromMeasurements(uint32_t currentTime) {
+
+    uint32_t bandFrequencies[AM_HFXO];
+
+    for (uint32_t band = 0; band < AM_HFXO; band += 1) {
+
+        bandFrequencies[band] = AudioMoth_getClockFrequency(band);
+
+    }
+
+    uint32_t writeCycles = clockCalibration->maximumWriteCycles > 0 ? clockCalibration->maximumWriteCycles : DEFAULT_WRITE_CYCLES;
+
+    uint32_t cyclesPerBuffer = clockCalibration->maximumDetectionCycles + writeCycles;
+
+    /* Each detection buffer spans this many samples at the capture rate */
+
+    bool selected = selectClockBand(bandFrequencies, AM_HFXO, CAPTURE_SAMPLE_RATE, configSettings->clockDivider, DECIMATION_FACTOR * DETECTOR_BUFFER_SIZE, cyclesPerBuffer, &clockCalibration->selection);
+
+    /* Fall back to the configured settings if no band is sufficient */
+
+    if (!selected) {
+
+        clockCalibration->selection.clockBand = configSettings->clockBand;
+
+        clockCalibration->selection.acquisitionCycles = configSettings->acquisitionCycles;
+
+        clockCalibration->selection.oversampleRate = configSettings->oversampleRate;
+
+    }
+
+    clockCalibration->valid = true;
+
+    clockCalibration->timeOfCalibration = currentTime;
+
+    clockCalibration->numberOfDetectionsMeasured = 0;
+
+    clockCalibration->maximumDetectionCycles = 0;
+
+}
+
+/* Save recording to SD card after listen*/
+
+static void makeRecordingIfDetected(uint32_t currentTime, int16_t* buffer1, int16_t* buffer2, uint32_t detections, const onset_t *onset, bool enableLED) {
+
+    /* Initialise file system and open a new file */
+
+    PROFILE_START(PROFILE_SD_INITIALISATION)
+
+    RETURN_ON_ERROR(AudioMoth_enableFileSystem());
+
+    PROFILE_STOP(PROFILE_SD_INITIALISATION)
+
+    /* Open a file with the name as a UNIX time stamp in HEX */
 
     time_t rawtime = currentTime;
 
+    PROFILE_START(PROFILE_GMTIME)
+
     struct tm *time = gmtime(&rawtime);
 
+    PROFILE_STOP(PROFILE_GMTIME)
+
+    /* Create a folder for current month */
+
+    sprintf(folderName, "%02d_%04d", 1 + time->tm_mon, 1900 + time->tm_year);
+
+    sprintf(fileName, "%s\\%08X.WAV", folderName, (unsigned int)currentTime);
+
+    if (!AudioMoth_folderExists(folderName)) {
+
+        RETURN_ON_ERROR(AudioMoth_makeSDfolder(folderName));
+
+        RETURN_ON_ERROR(AudioMoth_openFile(fileName));
+
+    }
+
+    RETURN_ON_ERROR(AudioMoth_openFile(fileName));
+
+    /* Place the onset in the recording, which is the pair itself at the detector rate */
+
+    bool writePair = true;
+
+    uint32_t sampleRate = DETECTOR_SAMPLE_RATE;
+
+    uint32_t numberOfSamples = 2 * DETECTOR_BUFFER_SIZE;
+
+    uint32_t samplesPerDetectionSample = 1;
+
+    uint32_t onsetSample = onset->sampleInPair;
+
+#if DECIMATION_FACTOR > 1
+
+    /* Otherwise the recording is the completed full rate buffers, each detection sample following a whole number of capture samples */
+
+    uint32_t capturedBuffers = completedCaptureBuffers;
+
+    uint32_t currentWriteBuffer = capturedBuffers & (NUMBER_OF_BUFFERS - 1);
+
+    uint32_t fullRateOnsetSample = onset->sampleInStream * DECIMATION_FACTOR - (capturedBuffers - (NUMBER_OF_BUFFERS - 1)) * NUMBER_OF_SAMPLES_IN_BUFFER;
+
+    /* These cover only the end of the pair, so fall back to the pair if the onset is known to be earlier */
+
+    if (onset->time == 0 || fullRateOnsetSample < NUMBER_OF_SAMPLES_IN_DETECTION_RECORDING) {
+
+        writePair = false;
+
+        sampleRate = CAPTURE_SAMPLE_RATE;
+
+        numberOfSamples = NUMBER_OF_SAMPLES_IN_DETECTION_RECORDING;
+
+        samplesPerDetectionSample = DECIMATION_FACTOR;
+
+        onsetSample = fullRateOnsetSample;
+
+    }
+
+#endif
+
+    bool onsetValid = onset->time != 0 && onsetSample < numberOfSamples;
+
+    /* Keep only the detected span and its margins if trimming is enabled */
+
+    uint32_t trimStart = 0;
+
+    uint32_t trimEnd = numberOfSamples;
+
+    if (configSettings->trimDetectionRecordings && onsetValid && onset->spanLength > 0) {
+
+        uint32_t preMargin = configSettings->trimPreMargin * sampleRate / MILLISECONDS_IN_SECOND;
+
+        uint32_t postMargin = configSettings->trimPostMargin * sampleRate / MILLISECONDS_IN_SECOND;
+
+        trimStart = onsetSample > preMargin ? onsetSample - preMargin : 0;
+
+        trimEnd = MIN(numberOfSamples, onsetSample + onset->spanLength * samplesPerDetectionSample + postMargin);
+
+    }
+
+    /* Initialise the WAV header, which gives the rate of whichever was kept */
+
+    setHeaderDetails(sampleRate, trimEnd - trimStart);
+
+    setHeaderComment(currentTime, (uint8_t*)AM_UNIQUE_ID_START_ADDRESS, configSettings->gain);
+
+    if (onsetValid) {
+
+        setHeaderOnset(onset->time, onset->milliseconds, detections, onsetSample - trimStart, trimStart, numberOfSamples);
+
+    } else {
+
+        setHeaderOnset(0, 0, detections, 0, 0, numberOfSamples);
+
+    }
+
+    /* Write the file to SD card */
+
+    if (enableLED) {
+
+        AudioMoth_setRedLED(true);
+
+    }
+
+    PROFILE_START(PROFILE_SD_WRITE)
+
+    AudioMoth_seekInFile(0);
+
+    AudioMoth_writeToFile(&wavHeader, sizeof(wavHeader));
+
+    if (writePair) {
+
+        writeBufferInRange(buffer1, 0, DETECTOR_BUFFER_SIZE, trimStart, trimEnd);
+
+        writeBufferInRange(buffer2, DETECTOR_BUFFER_SIZE, DETECTOR_BUFFER_SIZE, trimStart, trimEnd);
+
+    }
+
+#if DECIMATION_FACTOR > 1
+
+    /* Write the completed full rate buffers, which end with the most recent part of the pair. The oldest is next to be overwritten, so is written first while the SD card outpaces the microphone */
+
+    if (!writePair) {
+
+        for (uint32_t i = 1; i < NUMBER_OF_BUFFERS; i += 1) {
+
+            writeBufferInRange(buffers[(currentWriteBuffer + i) & (NUMBER_OF_BUFFERS - 1)], (i - 1) * NUMBER_OF_SAMPLES_IN_BUFFER, NUMBER_OF_SAMPLES_IN_BUFFER, trimStart, trimEnd);
+
+        }
+
+    }
+
+#endif
+
+    AudioMoth_setRedLED(false);
+
+    /* Close the file */
+
+    AudioMoth_closeFile();
+
+    PROFILE_STOP(PROFILE_SD_WRITE)
+
+    AudioMoth_disableFileSystem();
+
+}
+
+/* Write the part of a buffer, which starts at the given sample of the recording, that falls in the range kept */
+
+static void writeBufferInRange(int16_t *buffer, uint32_t bufferStart, uint32_t bufferLength, uint32_t start, uint32_t end) {
+
+    uint32_t first = MAX(start, bufferStart);
+
+    uint32_t last = MIN(end, bufferStart + bufferLength);
+
+    if (first < last) {
+
+        AudioMoth_writeToFile(buffer + first - bufferStart, 2 * (last - first));
+
+    }
+
+}
+
+/* Save recording to SD card */
+
+static void makeRecording(uint32_t currentTime, uint32_t recordDuration, bool enableLED) {
+
+    /* Calculate recording parameters */
+
+    uint32_t numberOfSamplesInHeader = sizeof(wavHeader) >> 1;
+
+    uint32_t numberOfSamples = configSettings->sampleRate * recordDuration;
+
+    /* Initialise file system and open a new file */
+
+    PROFILE_START(PROFILE_SD_INITIALISATION)
+
+    RETURN_ON_ERROR(AudioMoth_enableFileSystem());
+
+    PROFILE_STOP(PROFILE_SD_INITIALISATION)
+
+    /* Open a file with the name as a UNIX time stamp in HEX */
+
+    time_t rawtime = currentTime;
+
+    PROFILE_START(PROFILE_GMTIME)
+
+    struct tm *time = gmtime(&rawtime);
+
+    PROFILE_STOP(PROFILE_GMTIME)
+
     /* Create a folder for current month */
 
     sprintf(folderName, "%02d_%04d", 1 + time->tm_mon, 1900 + time->tm_year);
@@ -770,8 +1531,12 @@ static void makeRecording(uint32_t currentTime, uint32_t recordDuration, bool en
 
             }
 
+            PROFILE_START(PROFILE_SD_WRITE)
+
             AudioMoth_writeToFile(buffers[readBuffer], 2 * numberOfSamplesToWrite);
 
+            PROFILE_STOP(PROFILE_SD_WRITE)
+
             /* Increment buffer counters */
 
             readBuffer = (readBuffer + 1) & (NUMBER_OF_BUFFERS - 1);
@@ -800,6 +1565,8 @@ static void makeRecording(uint32_t currentTime, uint32_t recordDuration, bool en
 
     setHeaderComment(currentTime, (uint8_t*)AM_UNIQUE_ID_START_ADDRESS, configSettings->gain);
 
+    setHeaderOnset(0, 0, 0, 0, 0, 0);
+
 
     /* Write the header */
 
@@ -835,22 +1602,188 @@ static void flashLedToIndicateBatteryLife(void){
 
     }
 
-    /* Flash LED */
+    /* Flash LED without waiting for the pattern to finish */
 
-    for (uint32_t i = 0; i < numberOfFlashes; i += 1) {
+    uint32_t offDuration = numberOfFlashes == LOW_BATTERY_LED_FLASHES ? SHORT_LED_FLASH_DURATION : LONG_LED_FLASH_DURATION;
 
-        FLASH_LED(Red, SHORT_LED_FLASH_DURATION)
+    AudioMoth_startLEDPattern(AM_LED_RED, numberOfFlashes, SHORT_LED_FLASH_DURATION, offDuration);
 
-        if (numberOfFlashes == LOW_BATTERY_LED_FLASHES) {
+}
 
-            AudioMoth_delay(SHORT_LED_FLASH_DURATION);
+/* Time the start of the first detection frame of the pair. The reference buffer ends at the given sample of the detection stream */
 
-        } else {
+static void getOnset(uint32_t referenceBuffer, uint32_t referenceSample, uint32_t pairStartSample, onset_t *onset) {
+
+    int16_t onsetFrame = getDetectionOnsetFrame();
+
+    if (onsetFrame < 0) {
+
+        return;
+
+    }
+
+    onset->sampleInPair = onsetFrame * getFeatureWindowLength();
+
+    onset->sampleInStream = pairStartSample + onset->sampleInPair;
+
+    onset->spanLength = (getDetectionEndFrame() + 1 - onsetFrame) * getFeatureWindowLength();
+
+    int32_t samplesAfterReference = (int32_t)(onset->sampleInStream - referenceSample);
+
+    int64_t milliseconds = (int64_t)detectionBufferTimes[referenceBuffer].time * MILLISECONDS_IN_SECOND + detectionBufferTimes[referenceBuffer].ticks * MILLISECONDS_IN_SECOND / AM_TIME_TICKS_PER_SECOND;
+
+    milliseconds += (int64_t)samplesAfterReference * MILLISECONDS_IN_SECOND / DETECTOR_SAMPLE_RATE;
+
+    onset->time = milliseconds / MILLISECONDS_IN_SECOND;
+
+    onset->milliseconds = milliseconds % MILLISECONDS_IN_SECOND;
+
+}
+
+/* Buffer a detection, writing the buffer out when it is full */
+
+static void logEvent(uint32_t currentTime, uint8_t flags, uint32_t detections, const onset_t *onset) {
+
+    eventRecord_t *event = events + numberOfEvents;
+
+    event->time = currentTime;
+
+    event->flags = flags;
+
+    event->batteryState = AudioMoth_getBatteryState();
+
+    event->detections = detections;
+
+    event->onsetTime = onset->time;
+
+    event->onsetMilliseconds = onset->milliseconds;
+
+    numberOfEvents += 1;
+
+    if (numberOfEvents == EVENT_BUFFER_LENGTH) {
+
+        writeEvents();
+
+    }
+
+}
+
+/* Append any buffered events to the events file */
+
+static void writeEvents(void) {
+
+    if (numberOfEvents == 0) {
+
+        return;
+
+    }
+
+    if (AudioMoth_enableFileSystem()) {
+
+        if (AudioMoth_appendFile(EVENTS_FILENAME)) {
+
+            /* A new file starts with the header describing its records */
+
+            if (AudioMoth_getFileSize() == 0) {
+
+                eventsFileHeader_t header = {.magic = EVENTS_FILE_MAGIC, .version = EVENTS_FILE_VERSION, .recordSize = sizeof(eventRecord_t)};
+
+                AudioMoth_writeToFile(&header, sizeof(eventsFileHeader_t));
+
+            }
+
+            AudioMoth_writeToFile(events, numberOfEvents * sizeof(eventRecord_t));
 
-            AudioMoth_delay(LONG_LED_FLASH_DURATION);
+            AudioMoth_closeFile();
 
         }
 
+        AudioMoth_disableFileSystem();
+
+    }
+
+    numberOfEvents = 0;
+
+}
+
+/* Read the model file in a single read and use it if it is valid, otherwise fall back to the compiled in models */
+
+static void loadModelFile(void) {
+
+    bool loaded = false;
+
+    memset(&modelFile, 0, sizeof(modelFile_t));
+
+    if (AudioMoth_enableFileSystem()) {
+
+        if (AudioMoth_openFileToRead(MODEL_FILENAME)) {
+
+            loaded = AudioMoth_readFile(MODEL_FILENAME, (int16_t*)&modelFile, sizeof(modelFile_t));
+
+            AudioMoth_closeFile();
+
+        }
+
+        AudioMoth_disableFileSystem();
+
     }
 
+    loadDetectorModels(loaded ? &modelFile : NULL);
+
 }
+
+#ifdef ENABLE_PROFILING
+
+/* Append the statistics for each stage to the profile file and start a new collection period */
+
+static void writeProfileStatistics(void) {
+
+    bool samplesRecorded = false;
+
+    for (uint32_t stage = 0; stage < NUMBER_OF_PROFILE_STAGES; stage += 1) {
+
+        if (getNumberOfProfileSamples(stage) > 0) {
+
+            samplesRecorded = true;
+
+        }
+
+    }
+
+    if (!samplesRecorded) {
+
+        return;
+
+    }
+
+    uint32_t currentTime = AudioMoth_getTime();
+
+    if (AudioMoth_enableFileSystem()) {
+
+        if (AudioMoth_appendFile(PROFILE_FILENAME)) {
+
+            for (uint32_t stage = 0; stage < NUMBER_OF_PROFILE_STAGES; stage += 1) {
+
+                if (getNumberOfProfileSamples(stage) > 0) {
+
+                    uint32_t length = formatProfileStatistics(stage, currentTime, profileLine, PROFILE_LINE_LENGTH);
+
+                    AudioMoth_writeToFile(profileLine, length);
+
+                }
+
+            }
+
+            AudioMoth_closeFile();
+
+        }
+
+        AudioMoth_disableFileSystem();
+
+    }
+
+    resetProfileStatistics();
+
+}
+
+#endif
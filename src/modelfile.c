@@ -0,0 +1,67 @@
+/****************************************************************************
+ * modelfile.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stddef.h>
+
+#include "modelfile.h"
+
+#define CRC32_POLYNOMIAL                    0xEDB88320
+
+/* Bitwise CRC-32, as the file is only checked once for each listening session */
+
+uint32_t calculateModelFileCRC(const modelFile_t *modelFile) {
+
+    const uint8_t *bytes = (const uint8_t*)modelFile + offsetof(modelFile_t, numberOfModels);
+
+    uint32_t length = sizeof(modelFile_t) - offsetof(modelFile_t, numberOfModels);
+
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (uint32_t i = 0; i < length; i += 1) {
+
+        crc ^= bytes[i];
+
+        for (uint32_t j = 0; j < 8; j += 1) {
+
+            crc = (crc >> 1) ^ (crc & 1 ? CRC32_POLYNOMIAL : 0);
+
+        }
+
+    }
+
+    return ~crc;
+
+}
+
+bool validateModelFile(const modelFile_t *modelFile, uint32_t numberOfBands) {
+
+    if (modelFile->magic != MODEL_FILE_MAGIC || modelFile->version != MODEL_FILE_VERSION || modelFile->size != sizeof(modelFile_t)) return false;
+
+    if (modelFile->numberOfModels == 0 || modelFile->numberOfModels > MODEL_FILE_MAXIMUM_MODELS) return false;
+
+    if (modelFile->crc != calculateModelFileCRC(modelFile)) return false;
+
+    for (uint32_t i = 0; i < modelFile->numberOfModels; i += 1) {
+
+        const hmmModel_t *model = modelFile->models + i;
+
+        if (model->numberOfStates == 0 || model->numberOfStates > HMM_MAXIMUM_STATES) return false;
+
+        if (model->numberOfFeatures == 0 || model->numberOfFeatures > HMM_MAXIMUM_FEATURES) return false;
+
+        for (uint32_t j = 0; j < model->numberOfFeatures; j += 1) {
+
+            if (model->featureIndices[j] >= numberOfBands) return false;
+
+        }
+
+        if (model->minimumDetectionFrames > model->maximumDetectionFrames) return false;
+
+    }
+
+    return true;
+
+}
@@ -0,0 +1,92 @@
+/****************************************************************************
+ * models.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stddef.h>
+
+#include "models.h"
+
+/* Features: 350 Hz, 1300 Hz, 3500 Hz */
+/* States: Silence, Impulse, Tail, Noise */
+
+/* Max HMM response to consider a gunshot, given upper limit of gunshot lengths in dataset is 1.5 seconds */
+/* (1.5 SECONDS * SAMPLE_RATE) / WINDOW_LENGTH = 93.75 */
+
+static const hmmModel_t gunshotModel = {
+    .name = "GUNSHOT",
+    .numberOfStates = 4,
+    .numberOfFeatures = 3,
+    .featureIndices = {0, 1, 2},
+    .detectionStates = (1 << 1) | (1 << 2),
+    .minimumDetectionFrames = 1,
+    .maximumDetectionFrames = 93,
+    .emissionFloor = 0.05f,
+    .emissionMean = {
+        {-3.254631f, -4.244978f, -4.455339f},
+        {-0.314364f, -0.511267f, -1.409444f},
+        {-2.002476f, -2.556155f, -3.690385f},
+        {-3.109867f, -3.689082f, -3.476363f}
+    },
+    .oneOverEmissionVariance = {
+        {2.607228f, 1.108950f, 1.083559f},
+        {0.227855f, 0.218091f, 0.140690f},
+        {0.534408f, 0.632945f, 0.722583f},
+        {1.886675f, 1.096767f, 0.771746f}
+    },
+    /* ONE_OVER_SQRT_2PI / SQRT_EMISSION_VARIANCE */
+    .normalisationFactors = {
+        {0.644169f, 0.420113f, 0.415276f},
+        {0.190432f, 0.186307f, 0.149638f},
+        {0.291640f, 0.317390f, 0.339120f},
+        {0.547972f, 0.417799f, 0.350467f}
+    },
+    .transitionMatrix = {
+        {0.98f, 0.01f, 0.00f, 0.01f},
+        {0.00f, 0.69f, 0.31f, 0.00f},
+        {0.07f, 0.00f, 0.92f, 0.01f},
+        {0.01f, 0.01f, 0.00f, 0.98f}
+    },
+    .initial = {0.86f, 0.07f, 0.00f, 0.07f}
+};
+
+/* Compiled in models, used when there is no valid model file */
+
+#define NUMBER_OF_COMPILED_MODELS           1
+
+static const hmmModel_t *const compiledModels[NUMBER_OF_COMPILED_MODELS] = {
+    &gunshotModel
+};
+
+const hmmModel_t *detectorModels[MAXIMUM_NUMBER_OF_DETECTOR_MODELS] = {
+    &gunshotModel
+};
+
+uint32_t numberOfDetectorModels = NUMBER_OF_COMPILED_MODELS;
+
+void useDetectorModels(const modelFile_t *modelFile) {
+
+    if (modelFile == NULL) {
+
+        for (uint32_t i = 0; i < NUMBER_OF_COMPILED_MODELS; i += 1) {
+
+            detectorModels[i] = compiledModels[i];
+
+        }
+
+        numberOfDetectorModels = NUMBER_OF_COMPILED_MODELS;
+
+        return;
+
+    }
+
+    for (uint32_t i = 0; i < modelFile->numberOfModels; i += 1) {
+
+        detectorModels[i] = modelFile->models + i;
+
+    }
+
+    numberOfDetectorModels = modelFile->numberOfModels;
+
+}
@@ -0,0 +1,130 @@
+/****************************************************************************
+ * powerpolicy.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <string.h>
+
+#include "audioMoth.h"
+#include "powerpolicy.h"
+
+/* Start a new consumption measurement from the current battery state */
+
+static void resetReference(powerPolicyState_t *state, uint32_t currentTime, uint32_t batteryState) {
+
+    state->referenceTime = currentTime;
+
+    state->referenceBatteryState = batteryState;
+
+    state->projectedTimeOfExhaustion = 0;
+
+}
+
+void initialisePowerPolicy(powerPolicyState_t *state) {
+
+    memset(state, 0, sizeof(powerPolicyState_t));
+
+    state->level = POWER_POLICY_FULL;
+
+}
+
+bool isPowerPolicyUpdateDue(powerPolicyState_t *state, uint32_t currentTime) {
+
+    return state->timeOfLastUpdate == 0 || currentTime - state->timeOfLastUpdate >= POWER_POLICY_UPDATE_INTERVAL;
+
+}
+
+powerPolicyLevel_t updatePowerPolicy(powerPolicyState_t *state, uint32_t currentTime, uint32_t batteryState, uint32_t targetTime) {
+
+    bool firstUpdate = state->timeOfLastUpdate == 0;
+
+    state->timeOfLastUpdate = currentTime;
+
+    if (targetTime == 0) {
+
+        state->level = POWER_POLICY_FULL;
+
+        return state->level;
+
+    }
+
+    if (batteryState == AM_BATTERY_LOW) {
+
+        state->level = NUMBER_OF_POWER_POLICY_LEVELS - 1;
+
+        return state->level;
+
+    }
+
+    /* Restart the measurement on the first update, or if the battery has been replaced or recovered */
+
+    if (firstUpdate || batteryState > state->referenceBatteryState || currentTime < state->referenceTime) {
+
+        resetReference(state, currentTime, batteryState);
+
+        return state->level;
+
+    }
+
+    /* Wait until enough of the battery has been used to estimate the rate */
+
+    uint32_t drop = state->referenceBatteryState - batteryState;
+
+    if (drop < POWER_POLICY_MINIMUM_DROP) {
+
+        return state->level;
+
+    }
+
+    /* Assume the remaining steps above the low threshold are used at the measured rate */
+
+    uint64_t elapsed = currentTime - state->referenceTime;
+
+    uint64_t remaining = elapsed * (batteryState - AM_BATTERY_LOW) / drop;
+
+    state->projectedTimeOfExhaustion = remaining + currentTime > UINT32_MAX ? UINT32_MAX : (uint32_t)(remaining + currentTime);
+
+    uint32_t previousLevel = state->level;
+
+    if (state->projectedTimeOfExhaustion < targetTime) {
+
+        if (state->level < NUMBER_OF_POWER_POLICY_LEVELS - 1) state->level += 1;
+
+    } else if (targetTime > currentTime && state->level > POWER_POLICY_FULL) {
+
+        uint64_t relaxTime = currentTime + (uint64_t)(targetTime - currentTime) * (100 + POWER_POLICY_RELAX_MARGIN) / 100;
+
+        if (state->projectedTimeOfExhaustion > relaxTime) state->level -= 1;
+
+    }
+
+    /* The consumption rate depends on the level, so measure again after a change */
+
+    if (state->level != previousLevel) {
+
+        resetReference(state, currentTime, batteryState);
+
+    }
+
+    return state->level;
+
+}
+
+bool powerPolicyAnalysesAlternatePairs(powerPolicyLevel_t level) {
+
+    return level == POWER_POLICY_ALTERNATE_PAIRS || level == POWER_POLICY_PRIORITY_HOURS_ALTERNATE_PAIRS;
+
+}
+
+bool powerPolicyAllowsHour(powerPolicyLevel_t level, uint32_t priorityHours, uint32_t hour) {
+
+    if (level == POWER_POLICY_PRIORITY_HOURS || level == POWER_POLICY_PRIORITY_HOURS_ALTERNATE_PAIRS) {
+
+        return (priorityHours & (1 << hour)) != 0;
+
+    }
+
+    return true;
+
+}
@@ -0,0 +1,179 @@
+/****************************************************************************
+ * profiler.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "profiler.h"
+
+#ifndef ARM_MATH_CM4
+
+#include <time.h>
+
+#endif
+
+/* Statistics for each stage are kept in RAM until written out */
+
+typedef struct {
+    uint32_t count;
+    uint32_t minimum;
+    uint32_t maximum;
+    uint64_t total;
+    uint16_t bins[NUMBER_OF_PROFILE_BINS];
+} profileStatistics_t;
+
+static profileStatistics_t statistics[NUMBER_OF_PROFILE_STAGES];
+
+static const char *stageNames[NUMBER_OF_PROFILE_STAGES] = {
+    "DETECTION",
+    "GOERTZEL",
+    "HMM",
+    "HMM_FORWARD",
+    "HMM_BACKTRACK",
+    "GMTIME",
+    "SD_INITIALISATION",
+    "SD_WRITE",
+    "BOOT_TO_FIRST_SAMPLE",
+    "WAKES_PER_BUFFER"
+};
+
+static const char *stageUnits[NUMBER_OF_PROFILE_STAGES] = {
+    PROFILE_UNITS,
+    PROFILE_UNITS,
+    PROFILE_UNITS,
+    PROFILE_UNITS,
+    PROFILE_UNITS,
+    PROFILE_UNITS,
+    PROFILE_UNITS,
+    PROFILE_UNITS,
+    "ms",
+    "wakes"
+};
+
+void initialiseProfiler(void) {
+
+    enableProfileCounter();
+
+    resetProfileStatistics();
+
+}
+
+void enableProfileCounter(void) {
+
+#ifdef ARM_MATH_CM4
+
+    /* Enable the DWT cycle counter */
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+    DWT->CYCCNT = 0;
+
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#endif
+
+}
+
+#ifndef ARM_MATH_CM4
+
+uint32_t getProfileCount(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec);
+
+}
+
+#endif
+
+void resetProfileStatistics(void) {
+
+    memset(statistics, 0, sizeof(statistics));
+
+}
+
+void recordProfileSample(profileStage_t stage, uint32_t count) {
+
+    profileStatistics_t *stageStatistics = statistics + stage;
+
+    if (stageStatistics->count == 0 || count < stageStatistics->minimum) {
+
+        stageStatistics->minimum = count;
+
+    }
+
+    if (count > stageStatistics->maximum) {
+
+        stageStatistics->maximum = count;
+
+    }
+
+    stageStatistics->count += 1;
+
+    stageStatistics->total += count;
+
+    /* Bin is the position of the highest set bit */
+
+    uint32_t bin = 0;
+
+    while (bin < NUMBER_OF_PROFILE_BINS - 1 && (count >> (bin + 1)) > 0) {
+
+        bin += 1;
+
+    }
+
+    if (stageStatistics->bins[bin] < UINT16_MAX) {
+
+        stageStatistics->bins[bin] += 1;
+
+    }
+
+}
+
+uint32_t getNumberOfProfileSamples(profileStage_t stage) {
+
+    return statistics[stage].count;
+
+}
+
+uint32_t formatProfileStatistics(profileStage_t stage, uint32_t currentTime, char *buffer, uint32_t size) {
+
+    profileStatistics_t *stageStatistics = statistics + stage;
+
+    uint32_t mean = stageStatistics->count > 0 ? stageStatistics->total / stageStatistics->count : 0;
+
+    /* Time, stage, units, count, min, max, mean, then histogram bins separated by semicolons */
+
+    int length = snprintf(buffer, size, "%08X,%s,%s,%u,%u,%u,%u,", (unsigned int)currentTime, stageNames[stage], stageUnits[stage],
+                          (unsigned int)stageStatistics->count, (unsigned int)stageStatistics->minimum, (unsigned int)stageStatistics->maximum, (unsigned int)mean);
+
+    for (uint32_t i = 0; i < NUMBER_OF_PROFILE_BINS && length > 0 && (uint32_t)length < size; i += 1) {
+
+        length += snprintf(buffer + length, size - length, i < NUMBER_OF_PROFILE_BINS - 1 ? "%u;" : "%u\n", (unsigned int)stageStatistics->bins[i]);
+
+    }
+
+    if (length < 0 || size < 2) {
+
+        return 0;
+
+    }
+
+    if ((uint32_t)length < size) {
+
+        return (uint32_t)length;
+
+    }
+
+    /* Keep the line terminated if the histogram was truncated */
+
+    buffer[size - 2] = '\n';
+
+    return size - 1;
+
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+ * ratelimiter.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include "ratelimiter.h"
+
+void initialiseRateLimiter(rateLimiter_t *limiter, uint32_t capacity, uint32_t currentTime) {
+
+    limiter->tokens = capacity;
+
+    limiter->timeOfLastRefill = currentTime;
+
+}
+
+bool takeRateLimiterToken(rateLimiter_t *limiter, uint32_t capacity, uint32_t refillInterval, uint32_t currentTime) {
+
+    /* Restart the refill if the clock has been set backwards */
+
+    if (currentTime < limiter->timeOfLastRefill) {
+
+        limiter->timeOfLastRefill = currentTime;
+
+    }
+
+    uint32_t intervals = (currentTime - limiter->timeOfLastRefill) / refillInterval;
+
+    if (limiter->tokens + intervals >= capacity) {
+
+        /* A full bucket does not accumulate time towards the next token */
+
+        limiter->tokens = capacity;
+
+        limiter->timeOfLastRefill = currentTime;
+
+    } else {
+
+        /* Keep the remainder of the current interval */
+
+        limiter->tokens += intervals;
+
+        limiter->timeOfLastRefill += intervals * refillInterval;
+
+    }
+
+    if (limiter->tokens == 0) {
+
+        return false;
+
+    }
+
+    limiter->tokens -= 1;
+
+    return true;
+
+}
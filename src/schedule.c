@@ -0,0 +1,124 @@
+/****************************************************************************
+ * schedule.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include "schedule.h"
+
+#define SECONDS_IN_MINUTE                   60
+#define MINUTES_IN_DAY                      1440
+#define SECONDS_IN_DAY                      (MINUTES_IN_DAY * SECONDS_IN_MINUTE)
+
+/* Occurrences of each period are considered from the previous day to two days ahead */
+/* The previous day covers periods crossing midnight into today, the later days allow windows to be merged across midnight */
+
+#define FIRST_DAY_OFFSET                    -1
+#define LAST_DAY_OFFSET                     2
+
+#define NUMBER_OF_DAYS                      (LAST_DAY_OFFSET - FIRST_DAY_OFFSET + 1)
+
+#define MAX_OCCURRENCES                     (NUMBER_OF_DAYS * MAX_START_STOP_PERIODS)
+
+typedef struct {
+    uint32_t startTime;
+    uint32_t stopTime;
+} occurrence_t;
+
+static occurrence_t occurrences[MAX_OCCURRENCES];
+
+bool calculateListeningWindow(startStopPeriod_t *periods, uint32_t numberOfPeriods, uint32_t currentTime, uint32_t *startTime, uint32_t *stopTime) {
+
+    if (numberOfPeriods > MAX_START_STOP_PERIODS) {
+
+        numberOfPeriods = MAX_START_STOP_PERIODS;
+
+    }
+
+    /* Expand each valid period into absolute occurrences around the current day */
+
+    uint32_t startOfToday = currentTime - currentTime % SECONDS_IN_DAY;
+
+    uint32_t numberOfOccurrences = 0;
+
+    for (uint32_t i = 0; i < numberOfPeriods; i += 1) {
+
+        startStopPeriod_t *period = periods + i;
+
+        if (period->startMinutes >= MINUTES_IN_DAY || period->stopMinutes > MINUTES_IN_DAY || period->startMinutes == period->stopMinutes) {
+
+            continue;
+
+        }
+
+        uint32_t durationInMinutes = period->stopMinutes > period->startMinutes ? period->stopMinutes - period->startMinutes : MINUTES_IN_DAY + period->stopMinutes - period->startMinutes;
+
+        for (int32_t day = FIRST_DAY_OFFSET; day <= LAST_DAY_OFFSET; day += 1) {
+
+            if (day < 0 && startOfToday < SECONDS_IN_DAY) {
+
+                continue;
+
+            }
+
+            occurrence_t *occurrence = occurrences + numberOfOccurrences;
+
+            occurrence->startTime = startOfToday + day * SECONDS_IN_DAY + SECONDS_IN_MINUTE * period->startMinutes;
+
+            occurrence->stopTime = occurrence->startTime + SECONDS_IN_MINUTE * durationInMinutes;
+
+            numberOfOccurrences += 1;
+
+        }
+
+    }
+
+    /* The current window is the earliest starting occurrence which has not yet stopped */
+
+    bool found = false;
+
+    for (uint32_t i = 0; i < numberOfOccurrences; i += 1) {
+
+        if (occurrences[i].stopTime > currentTime && (!found || occurrences[i].startTime < *startTime)) {
+
+            *startTime = occurrences[i].startTime;
+
+            *stopTime = occurrences[i].stopTime;
+
+            found = true;
+
+        }
+
+    }
+
+    if (!found) {
+
+        return false;
+
+    }
+
+    /* Extend the window over any occurrence which overlaps or abuts its stop time */
+
+    bool extended = true;
+
+    while (extended) {
+
+        extended = false;
+
+        for (uint32_t i = 0; i < numberOfOccurrences; i += 1) {
+
+            if (occurrences[i].startTime <= *stopTime && occurrences[i].stopTime > *stopTime) {
+
+                *stopTime = occurrences[i].stopTime;
+
+                extended = true;
+
+            }
+
+        }
+
+    }
+
+    return true;
+
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+ * batchgoertzel.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <math.h>
+
+#include "batchgoertzel.h"
+#include "goertzelbank.h"
+
+/* Windows are independent, so several are run together to hide the latency of each recurrence */
+
+#define WINDOWS_IN_FLIGHT                   4
+
+static const float coefficients[GOERTZEL_NUMBER_OF_BANDS] = GOERTZEL_COEFFICIENTS;
+
+void extractBatchFeatures(const int16_t *streams[BATCH_HMM_LANES], uint32_t numberOfSamples, batchLanes_t *values[]) {
+
+    batchLanes_t block[WINDOWS_IN_FLIGHT][GOERTZEL_WINDOW_LENGTH] = {{{0}}};
+
+    uint32_t numberOfWindows = numberOfSamples / GOERTZEL_WINDOW_LENGTH;
+
+    for (uint32_t window = 0; window < numberOfWindows; window += WINDOWS_IN_FLIGHT) {
+
+        uint32_t windowsInBlock = numberOfWindows - window < WINDOWS_IN_FLIGHT ? numberOfWindows - window : WINDOWS_IN_FLIGHT;
+
+        /* Interleave the windows of each stream, so the recurrence reads one vector per sample */
+
+        for (uint32_t k = 0; k < windowsInBlock; k++) {
+
+            for (uint32_t lane = 0; lane < BATCH_HMM_LANES; lane++) {
+
+                const int16_t *samples = streams[lane] + (window + k) * GOERTZEL_WINDOW_LENGTH;
+
+                for (uint32_t j = 0; j < GOERTZEL_WINDOW_LENGTH; j++) block[k][j][lane] = (float)samples[j];
+
+            }
+
+        }
+
+        batchLanes_t delay1[WINDOWS_IN_FLIGHT][GOERTZEL_NUMBER_OF_BANDS] = {{{0}}};
+
+        batchLanes_t delay2[WINDOWS_IN_FLIGHT][GOERTZEL_NUMBER_OF_BANDS] = {{{0}}};
+
+        for (uint32_t j = 0; j < GOERTZEL_WINDOW_LENGTH; j++) {
+
+            for (uint32_t k = 0; k < WINDOWS_IN_FLIGHT; k++) {
+
+                batchLanes_t scaledSample = block[k][j] * goertzelWindow[j];
+
+                for (uint32_t band = 0; band < GOERTZEL_NUMBER_OF_BANDS; band++) {
+
+                    batchLanes_t y = scaledSample + coefficients[band] * delay1[k][band] - delay2[k][band];
+
+                    delay2[k][band] = delay1[k][band];
+
+                    delay1[k][band] = y;
+
+                }
+
+            }
+
+        }
+
+        for (uint32_t k = 0; k < windowsInBlock; k++) {
+
+            for (uint32_t band = 0; band < GOERTZEL_NUMBER_OF_BANDS; band++) {
+
+                batchLanes_t power = delay1[k][band] * delay1[k][band] + delay2[k][band] * delay2[k][band] - delay1[k][band] * delay2[k][band] * coefficients[band];
+
+                for (uint32_t lane = 0; lane < BATCH_HMM_LANES; lane++) {
+
+                    values[band][window + k][lane] = power[lane] >= 0.0f ? sqrtf(power[lane]) : 0.0f;
+
+                }
+
+            }
+
+        }
+
+    }
+
+}
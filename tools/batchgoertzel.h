@@ -0,0 +1,28 @@
+/****************************************************************************
+ * batchgoertzel.h
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Goertzel bank for the host tools which runs the recurrence of the
+ * firmware bank for several independent streams at once, one stream in
+ * each lane of the batch decoder vectors, with the Hamming window and the
+ * band coefficients shared by every lane. Each stream may be a different
+ * file or a different part of one file.
+ *
+ * The amplitudes are written as one vector for each band and window, the
+ * layout read by setBatchFeatures(), and use the same operations in the
+ * same order as extractFeatures().
+ *****************************************************************************/
+
+#ifndef BATCHGOERTZEL_H_
+#define BATCHGOERTZEL_H_
+
+#include <stdint.h>
+
+#include "batchhmm.h"
+
+/* Run the bank over numberOfSamples samples of each stream, writing numberOfSamples / window length amplitudes for each band */
+
+void extractBatchFeatures(const int16_t *streams[BATCH_HMM_LANES], uint32_t numberOfSamples, batchLanes_t *values[]);
+
+#endif /* BATCHGOERTZEL_H_ */
@@ -0,0 +1,261 @@
+/****************************************************************************
+ * batchhmm.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batchhmm.h"
+
+/* Smallest feature value before taking logs, matching the zero emission of calculate() closely enough to never be chosen */
+
+#define MINIMUM_FEATURE                     1e-30f
+
+static inline batchLanes_t broadcast(float value) {
+
+    batchLanes_t lanes = {0};
+
+    return lanes + value;
+
+}
+
+/* Select b where the mask is set, otherwise a */
+
+static inline batchLanes_t blend(batchLanes_t a, batchLanes_t b, batchIndices_t mask) {
+
+    return (batchLanes_t)(((batchIndices_t)a & ~mask) | ((batchIndices_t)b & mask));
+
+}
+
+static inline batchLanes_t maximum(batchLanes_t a, batchLanes_t b) {
+
+    return blend(a, b, b > a);
+
+}
+
+batchDecoder_t* createBatchDecoder(const hmmModel_t *model) {
+
+    batchDecoder_t *decoder = NULL;
+
+    if (posix_memalign((void**)&decoder, sizeof(batchLanes_t), sizeof(batchDecoder_t)) != 0) return NULL;
+
+    memset(decoder, 0, sizeof(batchDecoder_t));
+
+    decoder->numberOfStates = model->numberOfStates;
+
+    decoder->numberOfFeatures = model->numberOfFeatures;
+
+    decoder->detectionStates = model->detectionStates;
+
+    memcpy(decoder->featureIndices, model->featureIndices, sizeof(decoder->featureIndices));
+
+    decoder->logFloor = broadcast(logf(model->emissionFloor));
+
+    for (uint8_t i = 0; i < model->numberOfStates; i++) {
+
+        for (uint8_t j = 0; j < model->numberOfFeatures; j++) {
+
+            decoder->mean[i][j] = broadcast(model->emissionMean[i][j]);
+
+            decoder->halfOneOverVariance[i][j] = broadcast(0.5f * model->oneOverEmissionVariance[i][j]);
+
+            decoder->logNormalisation[i][j] = broadcast(logf(model->normalisationFactors[i][j]));
+
+        }
+
+        for (uint8_t j = 0; j < model->numberOfStates; j++) {
+
+            decoder->logTransition[i][j] = broadcast(logf(model->transitionMatrix[i][j]));
+
+        }
+
+        decoder->logInitial[i] = broadcast(logf(model->initial[i]));
+
+    }
+
+    return decoder;
+
+}
+
+void destroyBatchDecoder(batchDecoder_t *decoder) {
+
+    free(decoder);
+
+}
+
+void setBatchStream(batchDecoder_t *decoder, uint32_t lane, float *features[], int16_t T) {
+
+    if (T > HMM_MAXIMUM_FRAMES) T = HMM_MAXIMUM_FRAMES;
+
+    for (uint8_t j = 0; j < decoder->numberOfFeatures; j++) {
+
+        float *values = features[decoder->featureIndices[j]];
+
+        for (int16_t t = 0; t < T; t++) {
+
+            float value = values[t] > MINIMUM_FEATURE ? values[t] : MINIMUM_FEATURE;
+
+            decoder->observations[t][j][lane] = logf(value);
+
+        }
+
+    }
+
+}
+
+void setBatchFeatures(batchDecoder_t *decoder, batchLanes_t *features[], int16_t T) {
+
+    if (T > HMM_MAXIMUM_FRAMES) T = HMM_MAXIMUM_FRAMES;
+
+    for (uint8_t j = 0; j < decoder->numberOfFeatures; j++) {
+
+        batchLanes_t *values = features[decoder->featureIndices[j]];
+
+        for (int16_t t = 0; t < T; t++) {
+
+            for (uint32_t lane = 0; lane < BATCH_HMM_LANES; lane++) {
+
+                float value = values[t][lane] > MINIMUM_FEATURE ? values[t][lane] : MINIMUM_FEATURE;
+
+                decoder->observations[t][j][lane] = logf(value);
+
+            }
+
+        }
+
+    }
+
+}
+
+void decodeBatch(batchDecoder_t *decoder, int16_t T, int16_t *detectionFrames) {
+
+    uint8_t numberOfStates = decoder->numberOfStates;
+
+    uint8_t numberOfFeatures = decoder->numberOfFeatures;
+
+    if (T > HMM_MAXIMUM_FRAMES) T = HMM_MAXIMUM_FRAMES;
+
+    batchLanes_t score[2][HMM_MAXIMUM_STATES];
+
+    batchLanes_t emit[HMM_MAXIMUM_STATES];
+
+    for (int16_t t = 0; t < T; t++) {
+
+        batchLanes_t *current = score[t & 1];
+
+        batchLanes_t *previous = score[(t + 1) & 1];
+
+        /* Log emissions, floored relative to the largest */
+
+        batchLanes_t maximumEmission = broadcast(-INFINITY);
+
+        for (uint8_t i = 0; i < numberOfStates; i++) {
+
+            batchLanes_t value = broadcast(0.0f);
+
+            for (uint8_t j = 0; j < numberOfFeatures; j++) {
+
+                batchLanes_t difference = decoder->observations[t][j] - decoder->mean[i][j];
+
+                value += decoder->logNormalisation[i][j] - difference * difference * decoder->halfOneOverVariance[i][j];
+
+            }
+
+            emit[i] = value;
+
+            maximumEmission = maximum(maximumEmission, value);
+
+        }
+
+        batchLanes_t emissionFloor = maximumEmission + decoder->logFloor;
+
+        for (uint8_t i = 0; i < numberOfStates; i++) emit[i] = maximum(emit[i], emissionFloor);
+
+        /* Best predecessor of each state, keeping the first on a tie as calculate() does */
+
+        if (t == 0) {
+
+            for (uint8_t i = 0; i < numberOfStates; i++) current[i] = decoder->logInitial[i] + emit[i];
+
+        } else {
+
+            for (uint8_t i = 0; i < numberOfStates; i++) {
+
+                batchLanes_t best = previous[0] + decoder->logTransition[0][i];
+
+                batchIndices_t argument = {0};
+
+                for (uint8_t j = 1; j < numberOfStates; j++) {
+
+                    batchLanes_t value = previous[j] + decoder->logTransition[j][i];
+
+                    batchIndices_t mask = value > best;
+
+                    best = blend(best, value, mask);
+
+                    argument = (argument & ~mask) | (mask & j);
+
+                }
+
+                current[i] = best + emit[i];
+
+                decoder->backPointers[t][i] = argument;
+
+            }
+
+        }
+
+        /* Keep the scores near zero so precision is not lost as they accumulate */
+
+        batchLanes_t largest = current[0];
+
+        for (uint8_t i = 1; i < numberOfStates; i++) largest = maximum(largest, current[i]);
+
+        largest = blend(largest, broadcast(0.0f), largest == broadcast(-INFINITY));
+
+        for (uint8_t i = 0; i < numberOfStates; i++) current[i] -= largest;
+
+    }
+
+    /* Backtrack each lane */
+
+    batchLanes_t *last = score[(T - 1) & 1];
+
+    for (uint32_t lane = 0; lane < BATCH_HMM_LANES; lane++) {
+
+        uint8_t *mpe = decoder->mpe[lane];
+
+        uint8_t state = 0;
+
+        for (uint8_t i = 1; i < numberOfStates; i++) {
+
+            if (last[i][lane] > last[state][lane]) state = i;
+
+        }
+
+        mpe[T - 1] = state;
+
+        for (int16_t t = T - 1; t > 0; t--) mpe[t - 1] = decoder->backPointers[t][mpe[t]][lane];
+
+        int16_t count = 0;
+
+        for (int16_t t = 0; t < T; t++) {
+
+            if (decoder->detectionStates & (1 << mpe[t])) count++;
+
+        }
+
+        detectionFrames[lane] = count;
+
+    }
+
+}
+
+const uint8_t* getBatchMostProbableExplanation(const batchDecoder_t *decoder, uint32_t lane) {
+
+    return decoder->mpe[lane];
+
+}
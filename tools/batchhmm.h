@@ -0,0 +1,79 @@
+/****************************************************************************
+ * batchhmm.h
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Viterbi decoder for the host tools which runs one model over several
+ * independent streams at once, one stream in each lane of a vector. The
+ * decode is done with log probabilities, so each frame costs additions,
+ * multiplications and maxima with no exponentials, and the logarithm of
+ * each feature is taken once rather than once for each state.
+ *
+ * The lanes use the GCC vector extensions, so the compiler maps them onto
+ * AVX2 or AVX-512 on x86, NEON on ARM, or scalar code elsewhere. Eight
+ * lanes fill an AVX2 register. Build with -mavx512f -DBATCH_HMM_LANES=16
+ * to fill an AVX-512 register.
+ *
+ * The decoded paths are those of calculate(), which scales the emissions
+ * and the path probabilities each frame, except where two paths differ by
+ * less than the rounding of the two calculations or where the products in
+ * calculate() underflow to zero.
+ *****************************************************************************/
+
+#ifndef BATCHHMM_H_
+#define BATCHHMM_H_
+
+#include <stdint.h>
+
+#include "hmm.h"
+
+#ifndef BATCH_HMM_LANES
+#define BATCH_HMM_LANES                     8
+#endif
+
+typedef float batchLanes_t __attribute__((vector_size(BATCH_HMM_LANES * sizeof(float))));
+
+typedef int32_t batchIndices_t __attribute__((vector_size(BATCH_HMM_LANES * sizeof(int32_t))));
+
+/* Model parameters in the log domain, broadcast to every lane, with the observations and back pointers for each frame */
+/* stored as one vector for each feature or state */
+
+typedef struct {
+    uint8_t numberOfStates;
+    uint8_t numberOfFeatures;
+    uint8_t featureIndices[HMM_MAXIMUM_FEATURES];
+    uint8_t detectionStates;
+    batchLanes_t logFloor;
+    batchLanes_t mean[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+    batchLanes_t halfOneOverVariance[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+    batchLanes_t logNormalisation[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+    batchLanes_t logTransition[HMM_MAXIMUM_STATES][HMM_MAXIMUM_STATES];
+    batchLanes_t logInitial[HMM_MAXIMUM_STATES];
+    batchLanes_t observations[HMM_MAXIMUM_FRAMES][HMM_MAXIMUM_FEATURES];
+    batchIndices_t backPointers[HMM_MAXIMUM_FRAMES][HMM_MAXIMUM_STATES];
+    uint8_t mpe[BATCH_HMM_LANES][HMM_MAXIMUM_FRAMES];
+} batchDecoder_t;
+
+/* Allocate a decoder for a model, aligned for the vector width. Returns NULL on failure */
+
+batchDecoder_t* createBatchDecoder(const hmmModel_t *model);
+
+void destroyBatchDecoder(batchDecoder_t *decoder);
+
+/* Load T frames of the features laid out as by extractFeatures() into one lane */
+
+void setBatchStream(batchDecoder_t *decoder, uint32_t lane, float *features[], int16_t T);
+
+/* Load T frames of every lane from one vector for each band and frame, as written by extractBatchFeatures() */
+
+void setBatchFeatures(batchDecoder_t *decoder, batchLanes_t *features[], int16_t T);
+
+/* Decode T frames in every lane, writing the number of frames in the detection states for each lane */
+
+void decodeBatch(batchDecoder_t *decoder, int16_t T, int16_t *detectionFrames);
+
+/* State of each frame on the most likely path of a lane found by the last call to decodeBatch */
+
+const uint8_t* getBatchMostProbableExplanation(const batchDecoder_t *decoder, uint32_t lane);
+
+#endif /* BATCHHMM_H_ */
@@ -0,0 +1,212 @@
+/****************************************************************************
+ * batterysim.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Host-side simulation of the battery power policy. Replays a battery curve
+ * recorded at full duty, scaling the rate at which it is used by the level
+ * chosen by the firmware policy, and reports when the battery is exhausted.
+ *
+ * The curve is a CSV file of lines "seconds,batteryState" where the battery
+ * state is the AM_batteryState_t value reported by the device.
+ *
+ * Build: cc -O2 -I../inc -o batterysim batterysim.c ../src/powerpolicy.c
+ * Usage: batterysim curve.csv [-t targetDays] [-p priorityHours] [-a alternateCost] [-s sleepCost]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "powerpolicy.h"
+
+#define MAXIMUM_NUMBER_OF_RECORDS           65536
+
+#define SECONDS_IN_HOUR                     (60 * 60)
+#define SECONDS_IN_DAY                      (24 * SECONDS_IN_HOUR)
+
+/* Simulation starts at an arbitrary non-zero time, as the policy treats zero as never updated */
+
+#define START_TIME                          1500000000
+
+/* Default relative cost of each mode compared with full duty listening */
+
+#define DEFAULT_ALTERNATE_COST              0.6
+#define DEFAULT_SLEEP_COST                  0.05
+#define DEFAULT_PRIORITY_HOURS              0x80003F
+
+typedef struct {
+    double time;
+    uint32_t batteryState;
+} batteryRecord_t;
+
+static batteryRecord_t records[MAXIMUM_NUMBER_OF_RECORDS];
+
+static uint32_t numberOfRecords;
+
+static const char *levelNames[NUMBER_OF_POWER_POLICY_LEVELS] = {
+    "FULL",
+    "ALTERNATE_PAIRS",
+    "PRIORITY_HOURS",
+    "PRIORITY_HOURS_ALTERNATE_PAIRS"
+};
+
+static int readCurve(const char *filename) {
+
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL) return 1;
+
+    double time;
+
+    unsigned int batteryState;
+
+    while (numberOfRecords < MAXIMUM_NUMBER_OF_RECORDS && fscanf(file, "%lf,%u", &time, &batteryState) == 2) {
+
+        records[numberOfRecords].time = time;
+
+        records[numberOfRecords].batteryState = batteryState;
+
+        numberOfRecords += 1;
+
+    }
+
+    fclose(file);
+
+    return numberOfRecords == 0;
+
+}
+
+/* Battery state after the given number of full duty seconds */
+
+static uint32_t getBatteryState(double usage) {
+
+    uint32_t batteryState = records[0].batteryState;
+
+    for (uint32_t i = 0; i < numberOfRecords && records[i].time <= usage; i += 1) {
+
+        batteryState = records[i].batteryState;
+
+    }
+
+    return batteryState;
+
+}
+
+static double getHourCost(uint32_t level, uint32_t priorityHours, uint32_t hour, double alternateCost, double sleepCost) {
+
+    if (!powerPolicyAllowsHour(level, priorityHours, hour)) return sleepCost;
+
+    return powerPolicyAnalysesAlternatePairs(level) ? alternateCost : 1.0;
+
+}
+
+int main(int argc, char **argv) {
+
+    double targetDays = 0;
+
+    uint32_t priorityHours = DEFAULT_PRIORITY_HOURS;
+
+    double alternateCost = DEFAULT_ALTERNATE_COST;
+
+    double sleepCost = DEFAULT_SLEEP_COST;
+
+    if (argc < 2 || readCurve(argv[1])) {
+
+        fprintf(stderr, "Usage: %s curve.csv [-t targetDays] [-p priorityHours] [-a alternateCost] [-s sleepCost]\n", argv[0]);
+
+        return 1;
+
+    }
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+
+        if (strcmp(argv[i], "-t") == 0) {
+
+            targetDays = atof(argv[i + 1]);
+
+        } else if (strcmp(argv[i], "-p") == 0) {
+
+            priorityHours = strtoul(argv[i + 1], NULL, 0);
+
+        } else if (strcmp(argv[i], "-a") == 0) {
+
+            alternateCost = atof(argv[i + 1]);
+
+        } else if (strcmp(argv[i], "-s") == 0) {
+
+            sleepCost = atof(argv[i + 1]);
+
+        } else {
+
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+
+            return 1;
+
+        }
+
+    }
+
+    uint32_t targetTime = targetDays > 0 ? START_TIME + (uint32_t)(targetDays * SECONDS_IN_DAY) : 0;
+
+    double exhaustionUsage = records[numberOfRecords - 1].time;
+
+    powerPolicyState_t state;
+
+    initialisePowerPolicy(&state);
+
+    uint32_t currentTime = START_TIME;
+
+    double usage = 0;
+
+    uint32_t hoursAtLevel[NUMBER_OF_POWER_POLICY_LEVELS] = {0};
+
+    /* Step an hour at a time, updating the policy as often as the firmware would */
+
+    while (usage < exhaustionUsage) {
+
+        uint32_t batteryState = getBatteryState(usage);
+
+        if (isPowerPolicyUpdateDue(&state, currentTime)) {
+
+            uint32_t previousLevel = state.level;
+
+            updatePowerPolicy(&state, currentTime, batteryState, targetTime);
+
+            if (state.level != previousLevel) {
+
+                printf("Day %6.2f: battery state %2u, level %s\n", (double)(currentTime - START_TIME) / SECONDS_IN_DAY, (unsigned int)batteryState, levelNames[state.level]);
+
+            }
+
+        }
+
+        uint32_t hour = (currentTime % SECONDS_IN_DAY) / SECONDS_IN_HOUR;
+
+        usage += SECONDS_IN_HOUR * getHourCost(state.level, priorityHours, hour, alternateCost, sleepCost);
+
+        hoursAtLevel[state.level] += 1;
+
+        currentTime += SECONDS_IN_HOUR;
+
+    }
+
+    printf("Exhausted after %.2f days", (double)(currentTime - START_TIME) / SECONDS_IN_DAY);
+
+    if (targetTime > 0) {
+
+        printf(", target %.2f days, %s", targetDays, currentTime >= targetTime ? "reached" : "missed");
+
+    }
+
+    printf("\n");
+
+    for (uint32_t i = 0; i < NUMBER_OF_POWER_POLICY_LEVELS; i += 1) {
+
+        printf("%-32s %8u hours\n", levelNames[i], (unsigned int)hoursAtLevel[i]);
+
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,161 @@
+/****************************************************************************
+ * costmodel.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Host-side cost model of the detection pipeline. Estimates the Cortex-M4F
+ * cycles spent per buffer from operation counts and chooses a clock band
+ * with the same selection used by the firmware.
+ *
+ * Build: cc -O2 -I../inc -o costmodel costmodel.c ../src/clockband.c
+ * Usage: costmodel [-r sampleRate] [-d clockDivider] [-w writeCycles]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clockband.h"
+
+/* Detector geometry, matching src/detector.c and src/hmm.c */
+
+#define SAMPLE_COUNT                        32000
+#define BUFFER_SIZE                         16000
+#define WINDOW_LENGTH                       128
+#define WINDOW_COUNT                        (SAMPLE_COUNT / WINDOW_LENGTH)
+#define NUMBER_OF_BANDS                     3
+#define NUMBER_OF_STATES                    4
+#define NUMBER_OF_FEATURES                  3
+
+/* Estimated Cortex-M4F costs in cycles. External SRAM is read over the 8-bit EBI, so each sample needs two bus cycles */
+
+#define EXTERNAL_SAMPLE_LOAD_CYCLES         16
+#define INTERNAL_LOAD_CYCLES                2
+#define STORE_CYCLES                        1
+#define FLOAT_OPERATION_CYCLES              1
+#define FLOAT_CONVERSION_CYCLES             1
+#define FLOAT_DIVIDE_CYCLES                 14
+#define FLOAT_SQRT_CYCLES                   14
+#define BRANCH_CYCLES                       3
+#define DOUBLE_LOG_CYCLES                   1200
+#define FLOAT_EXP_CYCLES                    150
+
+/* Write path when no measurement is available, matching DEFAULT_WRITE_CYCLES in src/main.c */
+
+#define DEFAULT_WRITE_CYCLES                4000000
+
+#define NUMBER_OF_BANDS_TO_SELECT           6
+
+static const uint32_t bandFrequencies[NUMBER_OF_BANDS_TO_SELECT] = {1200000, 6600000, 11000000, 14000000, 21000000, 28000000};
+
+static const char *bandNames[NUMBER_OF_BANDS_TO_SELECT] = {"AM_HFRCO_1MHZ", "AM_HFRCO_7MHZ", "AM_HFRCO_11MHZ", "AM_HFRCO_14MHZ", "AM_HFRCO_21MHZ", "AM_HFRCO_28MHZ"};
+
+static uint64_t goertzelCycles(void) {
+
+    /* Load, buffer selection, conversion and windowing of each sample */
+
+    uint64_t perSample = EXTERNAL_SAMPLE_LOAD_CYCLES + BRANCH_CYCLES + FLOAT_CONVERSION_CYCLES + INTERNAL_LOAD_CYCLES + FLOAT_OPERATION_CYCLES;
+
+    /* One multiply and two additions for each band's recurrence, plus the loop counter */
+
+    perSample += NUMBER_OF_BANDS * 3 * FLOAT_OPERATION_CYCLES + BRANCH_CYCLES;
+
+    /* Magnitude of each band at the end of a window */
+
+    uint64_t perWindow = NUMBER_OF_BANDS * (5 * FLOAT_OPERATION_CYCLES + FLOAT_SQRT_CYCLES + STORE_CYCLES) + BRANCH_CYCLES;
+
+    return perSample * SAMPLE_COUNT + perWindow * WINDOW_COUNT;
+
+}
+
+static uint64_t hmmForwardCycles(void) {
+
+    /* Each log-normal density takes a double precision log, a float exp and five float operations */
+
+    uint64_t perDensity = DOUBLE_LOG_CYCLES + FLOAT_EXP_CYCLES + 5 * FLOAT_OPERATION_CYCLES + 3 * INTERNAL_LOAD_CYCLES;
+
+    uint64_t emissions = NUMBER_OF_STATES * (NUMBER_OF_FEATURES * (perDensity + FLOAT_OPERATION_CYCLES) + BRANCH_CYCLES) + NUMBER_OF_STATES * BRANCH_CYCLES;
+
+    /* Two multiplies and a compare for every transition, then normalisation of each state */
+
+    uint64_t transitions = NUMBER_OF_STATES * NUMBER_OF_STATES * (2 * FLOAT_OPERATION_CYCLES + 2 * INTERNAL_LOAD_CYCLES + BRANCH_CYCLES);
+
+    uint64_t normalisation = NUMBER_OF_STATES * (FLOAT_OPERATION_CYCLES + FLOAT_DIVIDE_CYCLES + BRANCH_CYCLES + STORE_CYCLES);
+
+    return (emissions + transitions + normalisation) * WINDOW_COUNT;
+
+}
+
+static uint64_t hmmBacktrackCycles(void) {
+
+    return (2 * INTERNAL_LOAD_CYCLES + STORE_CYCLES + 2 * BRANCH_CYCLES) * WINDOW_COUNT;
+
+}
+
+int main(int argc, char **argv) {
+
+    uint32_t sampleRate = 8000;
+
+    uint32_t clockDivider = 1;
+
+    uint32_t writeCycles = DEFAULT_WRITE_CYCLES;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        if (strcmp(argv[i], "-r") == 0) {
+
+            sampleRate = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-d") == 0) {
+
+            clockDivider = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-w") == 0) {
+
+            writeCycles = strtoul(argv[i + 1], NULL, 10);
+
+        } else {
+
+            fprintf(stderr, "Usage: %s [-r sampleRate] [-d clockDivider] [-w writeCycles]\n", argv[0]);
+
+            return 1;
+
+        }
+
+    }
+
+    uint64_t goertzel = goertzelCycles();
+
+    uint64_t forward = hmmForwardCycles();
+
+    uint64_t backtrack = hmmBacktrackCycles();
+
+    uint64_t cyclesPerBuffer = goertzel + forward + backtrack + writeCycles;
+
+    printf("GOERTZEL,%llu\n", (unsigned long long)goertzel);
+    printf("HMM_FORWARD,%llu\n", (unsigned long long)forward);
+    printf("HMM_BACKTRACK,%llu\n", (unsigned long long)backtrack);
+    printf("SD_WRITE,%u\n", writeCycles);
+    printf("TOTAL,%llu\n", (unsigned long long)cyclesPerBuffer);
+
+    for (uint32_t band = 0; band < NUMBER_OF_BANDS_TO_SELECT; band += 1) {
+
+        printf("%s,%.3f s per %.3f s buffer\n", bandNames[band], (double)cyclesPerBuffer / bandFrequencies[band], (double)BUFFER_SIZE / sampleRate);
+
+    }
+
+    clockBandSelection_t selection;
+
+    if (cyclesPerBuffer > UINT32_MAX || !selectClockBand(bandFrequencies, NUMBER_OF_BANDS_TO_SELECT, sampleRate, clockDivider, BUFFER_SIZE, (uint32_t)cyclesPerBuffer, &selection)) {
+
+        printf("No clock band is sufficient\n");
+
+        return 1;
+
+    }
+
+    printf("Selected %s with %u acquisition cycles and oversample rate %u\n", bandNames[selection.clockBand], selection.acquisitionCycles, selection.oversampleRate);
+
+    return 0;
+
+}
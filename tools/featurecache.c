@@ -0,0 +1,240 @@
+/****************************************************************************
+ * featurecache.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "featurecache.h"
+
+#define FLOAT16_EXPONENT_BIAS               15
+#define FLOAT32_EXPONENT_BIAS               127
+
+static size_t getBytesPerValue(uint32_t format) {
+
+    return format == FEATURE_CACHE_FLOAT16 ? sizeof(uint16_t) : sizeof(float);
+
+}
+
+/* IEEE half precision conversions, rounding to nearest even and keeping subnormals */
+
+static uint16_t floatToHalf(float value) {
+
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (bits >> 16) & 0x8000;
+
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - FLOAT32_EXPONENT_BIAS + FLOAT16_EXPONENT_BIAS;
+
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+    if (exponent >= 0x1F) return sign | 0x7C00;
+
+    if (exponent <= 0) {
+
+        if (exponent < -10) return sign;
+
+        mantissa |= 0x800000;
+
+        uint32_t shift = 14 - exponent;
+
+        uint32_t half = mantissa >> shift;
+
+        uint32_t remainder = mantissa & ((1 << shift) - 1);
+
+        uint32_t midpoint = 1 << (shift - 1);
+
+        if (remainder > midpoint || (remainder == midpoint && (half & 1))) half += 1;
+
+        return sign | half;
+
+    }
+
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+
+    uint32_t remainder = mantissa & 0x1FFF;
+
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half += 1;
+
+    return sign | half;
+
+}
+
+static float halfToFloat(uint16_t half) {
+
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+
+    uint32_t exponent = (half >> 10) & 0x1F;
+
+    uint32_t mantissa = half & 0x3FF;
+
+    uint32_t bits;
+
+    if (exponent == 0x1F) {
+
+        bits = sign | 0x7F800000 | (mantissa << 13);
+
+    } else if (exponent != 0) {
+
+        bits = sign | ((exponent - FLOAT16_EXPONENT_BIAS + FLOAT32_EXPONENT_BIAS) << 23) | (mantissa << 13);
+
+    } else if (mantissa == 0) {
+
+        bits = sign;
+
+    } else {
+
+        /* Normalise the subnormal */
+
+        exponent = FLOAT32_EXPONENT_BIAS - FLOAT16_EXPONENT_BIAS + 1;
+
+        while ((mantissa & 0x400) == 0) {
+
+            mantissa <<= 1;
+
+            exponent -= 1;
+
+        }
+
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+
+    }
+
+    float value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+
+}
+
+int writeFeatureCache(const char *filename, const featureCacheHeader_t *header, float *columns[]) {
+
+    if (header->numberOfBands > FEATURE_CACHE_MAXIMUM_BANDS) return 1;
+
+    FILE *file = fopen(filename, "wb");
+
+    if (file == NULL) return 1;
+
+    int result = fwrite(header, sizeof(featureCacheHeader_t), 1, file) != 1;
+
+    for (uint32_t band = 0; band < header->numberOfBands && result == 0; band += 1) {
+
+        if (header->format == FEATURE_CACHE_FLOAT16) {
+
+            for (uint32_t i = 0; i < header->numberOfWindows && result == 0; i += 1) {
+
+                uint16_t half = floatToHalf(columns[band][i]);
+
+                result = fwrite(&half, sizeof(uint16_t), 1, file) != 1;
+
+            }
+
+        } else {
+
+            result = fwrite(columns[band], sizeof(float), header->numberOfWindows, file) != header->numberOfWindows;
+
+        }
+
+    }
+
+    if (fclose(file) != 0) result = 1;
+
+    return result;
+
+}
+
+int openFeatureCache(const char *filename, featureCache_t *cache) {
+
+    memset(cache, 0, sizeof(featureCache_t));
+
+    int descriptor = open(filename, O_RDONLY);
+
+    if (descriptor < 0) return 1;
+
+    struct stat status;
+
+    if (fstat(descriptor, &status) != 0 || (size_t)status.st_size < sizeof(featureCacheHeader_t)) {
+
+        close(descriptor);
+
+        return 1;
+
+    }
+
+    void *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+    close(descriptor);
+
+    if (mapping == MAP_FAILED) return 1;
+
+    const featureCacheHeader_t *header = mapping;
+
+    size_t expectedSize = sizeof(featureCacheHeader_t) + (size_t)header->numberOfBands * header->numberOfWindows * getBytesPerValue(header->format);
+
+    bool valid = header->magic == FEATURE_CACHE_MAGIC && header->version == FEATURE_CACHE_VERSION && header->format <= FEATURE_CACHE_FLOAT16 && header->numberOfBands <= FEATURE_CACHE_MAXIMUM_BANDS && expectedSize == (size_t)status.st_size;
+
+    if (!valid) {
+
+        munmap(mapping, status.st_size);
+
+        return 1;
+
+    }
+
+    cache->header = header;
+
+    cache->columns = header + 1;
+
+    cache->mapping = mapping;
+
+    cache->size = status.st_size;
+
+    return 0;
+
+}
+
+void closeFeatureCache(featureCache_t *cache) {
+
+    if (cache->mapping != NULL) munmap(cache->mapping, cache->size);
+
+    memset(cache, 0, sizeof(featureCache_t));
+
+}
+
+const float* getFeatureCacheColumn(const featureCache_t *cache, uint32_t band) {
+
+    if (cache->header->format != FEATURE_CACHE_FLOAT32 || band >= cache->header->numberOfBands) return NULL;
+
+    return (const float*)cache->columns + (size_t)band * cache->header->numberOfWindows;
+
+}
+
+void readFeatureCache(const featureCache_t *cache, uint32_t band, uint32_t first, uint32_t count, float *values) {
+
+    size_t offset = (size_t)band * cache->header->numberOfWindows + first;
+
+    if (cache->header->format == FEATURE_CACHE_FLOAT16) {
+
+        const uint16_t *halves = (const uint16_t*)cache->columns + offset;
+
+        for (uint32_t i = 0; i < count; i += 1) values[i] = halfToFloat(halves[i]);
+
+    } else {
+
+        memcpy(values, (const float*)cache->columns + offset, count * sizeof(float));
+
+    }
+
+}
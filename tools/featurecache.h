@@ -0,0 +1,73 @@
+/****************************************************************************
+ * featurecache.h
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Columnar cache of the Goertzel amplitudes of a recording, so models can
+ * be evaluated again without running the filter bank. The file is a
+ * header followed by one column per band, holding the amplitude of every
+ * complete window of the recording as a 32-bit or 16-bit float. Windows
+ * never straddle a buffer, so the features of the pair starting at buffer
+ * n are the windows from n * windows per buffer onwards in each column.
+ *
+ * A 128-sample window of 16-bit audio is 256 bytes, against 12 bytes for
+ * three 32-bit amplitudes or 6 bytes for three 16-bit amplitudes.
+ *****************************************************************************/
+
+#ifndef FEATURECACHE_H_
+#define FEATURECACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FEATURE_CACHE_MAGIC                 0x43525446
+#define FEATURE_CACHE_VERSION               1
+
+#define FEATURE_CACHE_MAXIMUM_BANDS         16
+
+#define FEATURE_CACHE_EXTENSION             ".ftc"
+
+typedef enum {FEATURE_CACHE_FLOAT32, FEATURE_CACHE_FLOAT16} featureCacheFormat_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t format;
+    uint32_t sampleRate;
+    uint32_t windowLength;
+    uint32_t numberOfBands;
+    uint32_t numberOfWindows;
+    uint32_t numberOfSamples;
+    uint32_t reserved;
+    float bandFrequencies[FEATURE_CACHE_MAXIMUM_BANDS];
+} featureCacheHeader_t;
+
+/* A cache file mapped into memory */
+
+typedef struct {
+    const featureCacheHeader_t *header;
+    const void *columns;
+    void *mapping;
+    size_t size;
+} featureCache_t;
+
+/* Write the header and the columns, each of header->numberOfWindows amplitudes, in the header format. Returns non-zero on failure */
+
+int writeFeatureCache(const char *filename, const featureCacheHeader_t *header, float *columns[]);
+
+/* Map a cache file and check its header. Returns non-zero on failure */
+
+int openFeatureCache(const char *filename, featureCache_t *cache);
+
+void closeFeatureCache(featureCache_t *cache);
+
+/* The column of a 32-bit cache, which can be passed straight to the decoder. Returns NULL for a 16-bit cache */
+
+const float* getFeatureCacheColumn(const featureCache_t *cache, uint32_t band);
+
+/* Copy count amplitudes from the first window onwards in either format */
+
+void readFeatureCache(const featureCache_t *cache, uint32_t band, uint32_t first, uint32_t count, float *values);
+
+#endif /* FEATURECACHE_H_ */
@@ -0,0 +1,451 @@
+/****************************************************************************
+ * featurescan.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Offline scanner which runs the detection models over archived
+ * recordings in the overlapping pairs of two second buffers analysed by the
+ * listening loop. Each 8kHz WAV file is passed through the firmware
+ * Goertzel bank once, and with -w its amplitudes are kept in a feature
+ * cache next to it, as 16-bit floats with -h. Cache files given instead of
+ * recordings are mapped and decoded without the filter bank, so another
+ * model file can be evaluated over an archive by reading its caches.
+ *
+ * Pairs are decoded in batches, one in each lane of the batch decoder, so
+ * the last pairs of one file are decoded alongside the first of the next.
+ * With -s each pair is decoded by calculate() as in the firmware.
+ *
+ * Each detection is printed as the file, the start of the pair in seconds
+ * and the model name.
+ *
+ * Build: cc -O3 -march=native -Ihost -I../inc -o featurescan featurescan.c featurecache.c batchhmm.c wavfile.c ../src/detector.c ../src/hmm.c ../src/models.c ../src/modelfile.c -lm
+ * Usage: featurescan [-m MODEL.BIN] [-w] [-h] [-s] file.wav|file.ftc ...
+ *****************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+
+#include "detector.h"
+#include "models.h"
+#include "featurecache.h"
+#include "batchhmm.h"
+#include "wavfile.h"
+
+#define SAMPLE_RATE                         DETECTOR_SAMPLE_RATE
+#define BUFFER_SIZE                         DETECTOR_BUFFER_SIZE
+#define SAMPLE_COUNT                        (2 * BUFFER_SIZE)
+
+#define MAXIMUM_FILENAME_LENGTH             1024
+
+#define FREQUENCY_TOLERANCE                 0.01f
+
+static modelFile_t modelFile;
+
+static int16_t pair[SAMPLE_COUNT];
+
+/* Batch decoder for each model, and the file and first window of the pair in each lane */
+
+static bool scalarDecoding;
+
+static batchDecoder_t *decoders[MAXIMUM_NUMBER_OF_DETECTOR_MODELS];
+
+static const char *laneFilenames[BATCH_HMM_LANES];
+
+static uint32_t laneWindows[BATCH_HMM_LANES];
+
+static uint32_t numberOfLanesUsed;
+
+/* Totals over all the files */
+
+static uint64_t totalPairs;
+
+static uint64_t totalBytes;
+
+static uint64_t totalDetections[MAXIMUM_NUMBER_OF_DETECTOR_MODELS];
+
+static double getSeconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+
+}
+
+static bool hasExtension(const char *filename, const char *extension) {
+
+    size_t length = strlen(filename);
+
+    size_t extensionLength = strlen(extension);
+
+    return length >= extensionLength && strcasecmp(filename + length - extensionLength, extension) == 0;
+
+}
+
+static int loadModelFile(const char *filename) {
+
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL) return 1;
+
+    size_t bytesRead = fread(&modelFile, 1, sizeof(modelFile_t), file);
+
+    fclose(file);
+
+    return bytesRead != sizeof(modelFile_t) || !loadDetectorModels(&modelFile);
+
+}
+
+static void reportDetections(const char *filename, uint32_t first, uint32_t detections) {
+
+    for (uint32_t i = 0; i < numberOfDetectorModels; i += 1) {
+
+        if ((detections & (1 << i)) == 0) continue;
+
+        printf("%s %.0f %.*s\n", filename, (double)first * getFeatureWindowLength() / SAMPLE_RATE, HMM_MODEL_NAME_LENGTH, detectorModels[i]->name);
+
+        totalDetections[i] += 1;
+
+    }
+
+    totalPairs += 1;
+
+}
+
+/* Decode the pairs in the used lanes with every model, applying each model's limits to the counts */
+
+static void flushBatch(void) {
+
+    uint32_t detections[BATCH_HMM_LANES] = {0};
+
+    int16_t detectionFrames[BATCH_HMM_LANES];
+
+    for (uint32_t i = 0; i < numberOfDetectorModels; i += 1) {
+
+        decodeBatch(decoders[i], getNumberOfFeatureFrames(), detectionFrames);
+
+        for (uint32_t lane = 0; lane < numberOfLanesUsed; lane += 1) {
+
+            if (detectionFrames[lane] >= detectorModels[i]->minimumDetectionFrames && detectionFrames[lane] <= detectorModels[i]->maximumDetectionFrames) detections[lane] |= 1 << i;
+
+        }
+
+    }
+
+    for (uint32_t lane = 0; lane < numberOfLanesUsed; lane += 1) reportDetections(laneFilenames[lane], laneWindows[lane], detections[lane]);
+
+    numberOfLanesUsed = 0;
+
+}
+
+/* Decode every pair of buffers from the columns of window amplitudes, converting 16-bit caches one pair at a time */
+
+static void scanWindows(const char *filename, const float *columns[], const featureCache_t *cache, uint32_t numberOfWindows) {
+
+    uint32_t numberOfBands = getNumberOfFeatureBands();
+
+    uint32_t numberOfFrames = getNumberOfFeatureFrames();
+
+    uint32_t windowsPerBuffer = BUFFER_SIZE / getFeatureWindowLength();
+
+    float *values[FEATURE_CACHE_MAXIMUM_BANDS];
+
+    float *converted = cache == NULL ? NULL : malloc(numberOfBands * numberOfFrames * sizeof(float));
+
+    for (uint32_t first = 0; first + numberOfFrames <= numberOfWindows; first += windowsPerBuffer) {
+
+        for (uint32_t band = 0; band < numberOfBands; band += 1) {
+
+            if (cache == NULL) {
+
+                values[band] = (float*)columns[band] + first;
+
+            } else {
+
+                values[band] = converted + band * numberOfFrames;
+
+                readFeatureCache(cache, band, first, numberOfFrames, values[band]);
+
+            }
+
+        }
+
+        if (scalarDecoding) {
+
+            reportDetections(filename, first, detectFromFeatures(values));
+
+            continue;
+
+        }
+
+        for (uint32_t i = 0; i < numberOfDetectorModels; i += 1) setBatchStream(decoders[i], numberOfLanesUsed, values, numberOfFrames);
+
+        laneFilenames[numberOfLanesUsed] = filename;
+
+        laneWindows[numberOfLanesUsed] = first;
+
+        numberOfLanesUsed += 1;
+
+        if (numberOfLanesUsed == BATCH_HMM_LANES) flushBatch();
+
+    }
+
+    free(converted);
+
+}
+
+/* Run the filter bank over the consecutive pairs of the recording, which is the same as every overlapping pair as no window straddles a buffer */
+
+static int scanRecording(const char *filename, bool writeCache, featureCacheFormat_t format) {
+
+    uint32_t sampleRate, numberOfSamples;
+
+    int16_t *samples = readWavFile(filename, &sampleRate, &numberOfSamples);
+
+    if (samples == NULL || sampleRate != SAMPLE_RATE) {
+
+        fprintf(stderr, "Skipping %s, not a 16-bit mono 8kHz WAV file\n", filename);
+
+        free(samples);
+
+        return 1;
+
+    }
+
+    totalBytes += (uint64_t)numberOfSamples * sizeof(int16_t);
+
+    uint32_t numberOfBands = getNumberOfFeatureBands();
+
+    uint32_t numberOfFrames = getNumberOfFeatureFrames();
+
+    uint32_t windowLength = getFeatureWindowLength();
+
+    uint32_t numberOfWindows = numberOfSamples / windowLength;
+
+    /* Leave room for the windows of the last pair which fall beyond the end of the recording */
+
+    uint32_t capacity = (numberOfWindows / numberOfFrames + 1) * numberOfFrames;
+
+    float *columns[FEATURE_CACHE_MAXIMUM_BANDS];
+
+    float *values[FEATURE_CACHE_MAXIMUM_BANDS];
+
+    for (uint32_t band = 0; band < numberOfBands; band += 1) columns[band] = malloc(capacity * sizeof(float));
+
+    for (uint32_t start = 0; start < numberOfSamples; start += SAMPLE_COUNT) {
+
+        for (uint32_t band = 0; band < numberOfBands; band += 1) values[band] = columns[band] + start / windowLength;
+
+        if (start + SAMPLE_COUNT <= numberOfSamples) {
+
+            extractFeatures(samples + start, samples + start + BUFFER_SIZE, values);
+
+        } else {
+
+            memset(pair, 0, sizeof(pair));
+
+            memcpy(pair, samples + start, (numberOfSamples - start) * sizeof(int16_t));
+
+            extractFeatures(pair, pair + BUFFER_SIZE, values);
+
+        }
+
+    }
+
+    free(samples);
+
+    scanWindows(filename, (const float**)columns, NULL, numberOfWindows);
+
+    int result = 0;
+
+    if (writeCache) {
+
+        featureCacheHeader_t header;
+
+        memset(&header, 0, sizeof(featureCacheHeader_t));
+
+        header.magic = FEATURE_CACHE_MAGIC;
+
+        header.version = FEATURE_CACHE_VERSION;
+
+        header.format = format;
+
+        header.sampleRate = sampleRate;
+
+        header.windowLength = windowLength;
+
+        header.numberOfBands = numberOfBands;
+
+        header.numberOfWindows = numberOfWindows;
+
+        header.numberOfSamples = numberOfSamples;
+
+        for (uint32_t band = 0; band < numberOfBands; band += 1) header.bandFrequencies[band] = getFeatureBandFrequency(band);
+
+        char cacheFilename[MAXIMUM_FILENAME_LENGTH];
+
+        size_t length = strlen(filename) - (hasExtension(filename, ".wav") ? 4 : 0);
+
+        snprintf(cacheFilename, sizeof(cacheFilename), "%.*s%s", (int)length, filename, FEATURE_CACHE_EXTENSION);
+
+        result = writeFeatureCache(cacheFilename, &header, columns);
+
+        if (result) fprintf(stderr, "Could not write %s\n", cacheFilename);
+
+    }
+
+    for (uint32_t band = 0; band < numberOfBands; band += 1) free(columns[band]);
+
+    return result;
+
+}
+
+static int scanCache(const char *filename) {
+
+    featureCache_t cache;
+
+    if (openFeatureCache(filename, &cache)) {
+
+        fprintf(stderr, "Skipping %s, not a version %u feature cache\n", filename, FEATURE_CACHE_VERSION);
+
+        return 1;
+
+    }
+
+    const featureCacheHeader_t *header = cache.header;
+
+    bool matches = header->sampleRate == SAMPLE_RATE && header->windowLength == getFeatureWindowLength() && header->numberOfBands == getNumberOfFeatureBands();
+
+    for (uint32_t band = 0; band < header->numberOfBands && matches; band += 1) {
+
+        matches = fabsf(header->bandFrequencies[band] - getFeatureBandFrequency(band)) < FREQUENCY_TOLERANCE;
+
+    }
+
+    if (!matches) {
+
+        fprintf(stderr, "Skipping %s, made with a different Goertzel bank\n", filename);
+
+        closeFeatureCache(&cache);
+
+        return 1;
+
+    }
+
+    totalBytes += cache.size;
+
+    if (header->format == FEATURE_CACHE_FLOAT32) {
+
+        const float *columns[FEATURE_CACHE_MAXIMUM_BANDS];
+
+        for (uint32_t band = 0; band < header->numberOfBands; band += 1) columns[band] = getFeatureCacheColumn(&cache, band);
+
+        scanWindows(filename, columns, NULL, header->numberOfWindows);
+
+    } else {
+
+        scanWindows(filename, NULL, &cache, header->numberOfWindows);
+
+    }
+
+    closeFeatureCache(&cache);
+
+    return 0;
+
+}
+
+int main(int argc, char **argv) {
+
+    bool writeCache = false;
+
+    featureCacheFormat_t format = FEATURE_CACHE_FLOAT32;
+
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; i += 1) {
+
+        if (strcmp(argv[i], "-w") == 0) {
+
+            writeCache = true;
+
+        } else if (strcmp(argv[i], "-h") == 0) {
+
+            format = FEATURE_CACHE_FLOAT16;
+
+        } else if (strcmp(argv[i], "-s") == 0) {
+
+            scalarDecoding = true;
+
+        } else if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+
+            if (loadModelFile(argv[++i])) {
+
+                fprintf(stderr, "%s is not a valid model file for this Goertzel bank\n", argv[i]);
+
+                return 1;
+
+            }
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    if (i >= argc) {
+
+        fprintf(stderr, "Usage: %s [-m MODEL.BIN] [-w] [-h] [-s] file.wav|file.ftc ...\n", argv[0]);
+
+        return 1;
+
+    }
+
+    for (uint32_t j = 0; j < numberOfDetectorModels && !scalarDecoding; j += 1) {
+
+        decoders[j] = createBatchDecoder(detectorModels[j]);
+
+        if (decoders[j] == NULL) return 1;
+
+    }
+
+    double startTime = getSeconds();
+
+    int failures = 0;
+
+    for (; i < argc; i += 1) {
+
+        if (hasExtension(argv[i], FEATURE_CACHE_EXTENSION)) {
+
+            failures += scanCache(argv[i]);
+
+        } else {
+
+            failures += scanRecording(argv[i], writeCache, format);
+
+        }
+
+    }
+
+    if (numberOfLanesUsed > 0) flushBatch();
+
+    fprintf(stderr, "Scanned %llu pairs from %llu bytes in %.2f seconds", (unsigned long long)totalPairs, (unsigned long long)totalBytes, getSeconds() - startTime);
+
+    for (uint32_t j = 0; j < numberOfDetectorModels; j += 1) {
+
+        fprintf(stderr, ", %.*s %llu", HMM_MODEL_NAME_LENGTH, detectorModels[j]->name, (unsigned long long)totalDetections[j]);
+
+    }
+
+    fprintf(stderr, "\n");
+
+    return failures > 0;
+
+}
@@ -0,0 +1,191 @@
+/****************************************************************************
+ * fft.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fft.h"
+
+fftPlan_t* createFFTPlan(uint32_t length) {
+
+    if (length < 2 || (length & (length - 1)) != 0) return NULL;
+
+    fftPlan_t *plan = malloc(sizeof(fftPlan_t));
+
+    plan->length = length;
+
+    plan->twiddles = malloc(length / 2 * sizeof(fftComplex_t));
+
+    plan->bitReversal = malloc(length * sizeof(uint32_t));
+
+    /* Twiddles are calculated in double precision so errors do not build up over the stages */
+
+    for (uint32_t i = 0; i < length / 2; i += 1) {
+
+        double angle = -2.0 * M_PI * i / length;
+
+        plan->twiddles[i].real = cos(angle);
+
+        plan->twiddles[i].imaginary = sin(angle);
+
+    }
+
+    uint32_t numberOfBits = 0;
+
+    while ((1u << numberOfBits) < length) numberOfBits += 1;
+
+    for (uint32_t i = 0; i < length; i += 1) {
+
+        uint32_t reversed = 0;
+
+        for (uint32_t bit = 0; bit < numberOfBits; bit += 1) reversed |= ((i >> bit) & 1) << (numberOfBits - 1 - bit);
+
+        plan->bitReversal[i] = reversed;
+
+    }
+
+    return plan;
+
+}
+
+void destroyFFTPlan(fftPlan_t *plan) {
+
+    if (plan == NULL) return;
+
+    free(plan->twiddles);
+
+    free(plan->bitReversal);
+
+    free(plan);
+
+}
+
+void transformFFT(const fftPlan_t *plan, fftComplex_t *data, bool inverse) {
+
+    uint32_t length = plan->length;
+
+    for (uint32_t i = 0; i < length; i += 1) {
+
+        uint32_t j = plan->bitReversal[i];
+
+        if (j > i) {
+
+            fftComplex_t temporary = data[i];
+
+            data[i] = data[j];
+
+            data[j] = temporary;
+
+        }
+
+    }
+
+    /* The inverse uses the conjugate twiddles */
+
+    float sign = inverse ? -1.0f : 1.0f;
+
+    for (uint32_t size = 2; size <= length; size *= 2) {
+
+        uint32_t half = size / 2;
+
+        uint32_t stride = length / size;
+
+        for (uint32_t start = 0; start < length; start += size) {
+
+            for (uint32_t k = 0; k < half; k += 1) {
+
+                fftComplex_t twiddle = plan->twiddles[k * stride];
+
+                twiddle.imaginary *= sign;
+
+                fftComplex_t *even = data + start + k;
+
+                fftComplex_t *odd = even + half;
+
+                float real = odd->real * twiddle.real - odd->imaginary * twiddle.imaginary;
+
+                float imaginary = odd->real * twiddle.imaginary + odd->imaginary * twiddle.real;
+
+                odd->real = even->real - real;
+
+                odd->imaginary = even->imaginary - imaginary;
+
+                even->real += real;
+
+                even->imaginary += imaginary;
+
+            }
+
+        }
+
+    }
+
+}
+
+void transformTwoRealFFT(const fftPlan_t *plan, const float *a, uint32_t lengthA, const float *b, uint32_t lengthB, fftComplex_t *spectrumA, fftComplex_t *spectrumB, fftComplex_t *scratch) {
+
+    uint32_t length = plan->length;
+
+    memset(scratch, 0, length * sizeof(fftComplex_t));
+
+    for (uint32_t i = 0; i < lengthA && i < length; i += 1) scratch[i].real = a[i];
+
+    for (uint32_t i = 0; i < lengthB && i < length; i += 1) scratch[i].imaginary = b[i];
+
+    transformFFT(plan, scratch, false);
+
+    /* Separate the Hermitian and anti-Hermitian parts, which are the spectra of the real and imaginary signals */
+
+    for (uint32_t k = 0; k <= length / 2; k += 1) {
+
+        fftComplex_t z = scratch[k];
+
+        fftComplex_t mirror = scratch[(length - k) & (length - 1)];
+
+        spectrumA[k].real = 0.5f * (z.real + mirror.real);
+
+        spectrumA[k].imaginary = 0.5f * (z.imaginary - mirror.imaginary);
+
+        spectrumB[k].real = 0.5f * (z.imaginary + mirror.imaginary);
+
+        spectrumB[k].imaginary = 0.5f * (mirror.real - z.real);
+
+    }
+
+}
+
+void inverseTwoRealFFT(const fftPlan_t *plan, const fftComplex_t *spectrumA, const fftComplex_t *spectrumB, float *a, float *b, fftComplex_t *scratch) {
+
+    uint32_t length = plan->length;
+
+    /* Combine as A + iB over all frequencies, filling the negative frequencies from the conjugates */
+
+    for (uint32_t k = 0; k <= length / 2; k += 1) {
+
+        scratch[k].real = spectrumA[k].real - spectrumB[k].imaginary;
+
+        scratch[k].imaginary = spectrumA[k].imaginary + spectrumB[k].real;
+
+        if (k == 0 || k == length / 2) continue;
+
+        scratch[length - k].real = spectrumA[k].real + spectrumB[k].imaginary;
+
+        scratch[length - k].imaginary = spectrumB[k].real - spectrumA[k].imaginary;
+
+    }
+
+    transformFFT(plan, scratch, true);
+
+    for (uint32_t i = 0; i < length; i += 1) {
+
+        a[i] = scratch[i].real;
+
+        b[i] = scratch[i].imaginary;
+
+    }
+
+}
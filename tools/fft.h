@@ -0,0 +1,44 @@
+/****************************************************************************
+ * fft.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    float real;
+    float imaginary;
+} fftComplex_t;
+
+/* Twiddle factors and bit reversal permutation for a power of two length, shared read only between threads */
+
+typedef struct {
+    uint32_t length;
+    fftComplex_t *twiddles;
+    uint32_t *bitReversal;
+} fftPlan_t;
+
+/* Returns NULL if the length is not a power of two */
+
+fftPlan_t* createFFTPlan(uint32_t length);
+
+void destroyFFTPlan(fftPlan_t *plan);
+
+/* In place radix-2 transform. The inverse is not scaled by the length */
+
+void transformFFT(const fftPlan_t *plan, fftComplex_t *data, bool inverse);
+
+/* Transform two real signals, zero padded to the plan length, with one complex transform. Each spectrum holds the length / 2 + 1 non-negative frequencies */
+
+void transformTwoRealFFT(const fftPlan_t *plan, const float *a, uint32_t lengthA, const float *b, uint32_t lengthB, fftComplex_t *spectrumA, fftComplex_t *spectrumB, fftComplex_t *scratch);
+
+/* Inverse of two spectra of real signals with one complex transform, writing the plan length of samples of each without scaling */
+
+void inverseTwoRealFFT(const fftPlan_t *plan, const fftComplex_t *spectrumA, const fftComplex_t *spectrumB, float *a, float *b, fftComplex_t *scratch);
+
+#endif /* FFT_H_ */
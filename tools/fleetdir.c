@@ -0,0 +1,206 @@
+/****************************************************************************
+ * fleetdir.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+
+#include "fleetdir.h"
+#include "wavfile.h"
+
+#define HEXADECIMAL_TIME_LENGTH             8
+
+/* Onset chunk written by the firmware with each recording, all zero for scheduled recordings */
+
+#define ONSET_CHUNK_ID                      "onst"
+#define ONSET_CHUNK_SIZE                    20
+
+#define MILLISECONDS_IN_SECOND              1000.0
+
+static bool isMonthFolder(const char *name) {
+
+    return strlen(name) == FLEET_FOLDER_NAME_LENGTH && name[2] == '_' && strspn(name, "0123456789_") == FLEET_FOLDER_NAME_LENGTH;
+
+}
+
+static bool parseRecordingName(const char *name, uint32_t *nameTime) {
+
+    if (strlen(name) != FLEET_RECORDING_NAME_LENGTH || strcasecmp(name + HEXADECIMAL_TIME_LENGTH, ".WAV") != 0 || strspn(name, "0123456789ABCDEFabcdef") != HEXADECIMAL_TIME_LENGTH) return false;
+
+    *nameTime = strtoul(name, NULL, 16);
+
+    return true;
+
+}
+
+static int compareRecordings(const void *a, const void *b) {
+
+    const fleetRecording_t *first = a, *second = b;
+
+    return first->nameTime < second->nameTime ? -1 : first->nameTime > second->nameTime;
+
+}
+
+static void addRecordings(const char *directory, fleetDevice_t *device, const char *folder) {
+
+    char path[FLEET_MAXIMUM_PATH_LENGTH];
+
+    snprintf(path, sizeof(path), "%s/%s/%s", directory, device->name, folder);
+
+    DIR *monthFolder = opendir(path);
+
+    if (monthFolder == NULL) return;
+
+    struct dirent *entry;
+
+    while ((entry = readdir(monthFolder)) != NULL) {
+
+        uint32_t nameTime;
+
+        if (!parseRecordingName(entry->d_name, &nameTime)) continue;
+
+        device->recordings = realloc(device->recordings, (device->numberOfRecordings + 1) * sizeof(fleetRecording_t));
+
+        fleetRecording_t *recording = device->recordings + device->numberOfRecordings++;
+
+        snprintf(recording->name, sizeof(recording->name), "%s", entry->d_name);
+
+        snprintf(recording->folder, sizeof(recording->folder), "%s", folder);
+
+        recording->nameTime = nameTime;
+
+    }
+
+    closedir(monthFolder);
+
+}
+
+bool readFleetDirectory(const char *directory, fleetDevice_t **devices, uint32_t *numberOfDevices) {
+
+    *devices = NULL;
+
+    *numberOfDevices = 0;
+
+    DIR *fleet = opendir(directory);
+
+    if (fleet == NULL) return false;
+
+    struct dirent *entry;
+
+    while ((entry = readdir(fleet)) != NULL) {
+
+        if (entry->d_name[0] == '.' || strlen(entry->d_name) >= FLEET_MAXIMUM_NAME_LENGTH) continue;
+
+        char path[FLEET_MAXIMUM_PATH_LENGTH];
+
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+
+        DIR *card = opendir(path);
+
+        if (card == NULL) continue;
+
+        *devices = realloc(*devices, (*numberOfDevices + 1) * sizeof(fleetDevice_t));
+
+        fleetDevice_t *device = *devices + (*numberOfDevices)++;
+
+        memset(device, 0, sizeof(fleetDevice_t));
+
+        snprintf(device->name, sizeof(device->name), "%s", entry->d_name);
+
+        struct dirent *folder;
+
+        while ((folder = readdir(card)) != NULL) {
+
+            if (isMonthFolder(folder->d_name)) addRecordings(directory, device, folder->d_name);
+
+        }
+
+        closedir(card);
+
+        qsort(device->recordings, device->numberOfRecordings, sizeof(fleetRecording_t), compareRecordings);
+
+    }
+
+    closedir(fleet);
+
+    return true;
+
+}
+
+void freeFleetDirectory(fleetDevice_t *devices, uint32_t numberOfDevices) {
+
+    for (uint32_t i = 0; i < numberOfDevices; i += 1) free(devices[i].recordings);
+
+    free(devices);
+
+}
+
+void getFleetRecordingPath(const char *directory, const fleetDevice_t *device, const fleetRecording_t *recording, char *path, uint32_t length) {
+
+    snprintf(path, length, "%s/%s/%s/%s", directory, device->name, recording->folder, recording->name);
+
+}
+
+static uint32_t getOnsetField(const uint8_t *bytes, uint32_t length) {
+
+    uint32_t value = 0;
+
+    for (uint32_t i = 0; i < length; i += 1) value |= (uint32_t)bytes[i] << (8 * i);
+
+    return value;
+
+}
+
+bool getFleetRecordingStartTime(const char *path, const fleetRecording_t *recording, uint32_t sampleRate, uint32_t numberOfSamples, bool namedAtEnd, double *startTime) {
+
+    uint8_t onset[ONSET_CHUNK_SIZE];
+
+    uint32_t samplesBeforeNameTime = namedAtEnd ? numberOfSamples : 0;
+
+    if (readWavChunk(path, ONSET_CHUNK_ID, onset, sizeof(onset))) {
+
+        uint32_t onsetTime = getOnsetField(onset, 4);
+
+        uint32_t onsetMilliseconds = getOnsetField(onset + 4, 2);
+
+        uint32_t onsetSample = getOnsetField(onset + 8, 4);
+
+        uint32_t trimOffset = getOnsetField(onset + 12, 4);
+
+        uint32_t untrimmedSamples = getOnsetField(onset + 16, 4);
+
+        if (onsetTime != 0 && onsetMilliseconds < MILLISECONDS_IN_SECOND && onsetSample < numberOfSamples) {
+
+            *startTime = onsetTime + onsetMilliseconds / MILLISECONDS_IN_SECOND - (double)onsetSample / sampleRate;
+
+            return true;
+
+        }
+
+        /* Detection recordings give their untrimmed length, or at least the models which detected in chunks written before */
+        /* trimming was added, which are shorter and read as zero here. Scheduled recordings have an empty chunk */
+
+        uint32_t detections = getOnsetField(onset + 6, 2);
+
+        if (untrimmedSamples > trimOffset) {
+
+            samplesBeforeNameTime = untrimmedSamples - trimOffset;
+
+        } else {
+
+            samplesBeforeNameTime = detections != 0 ? numberOfSamples : 0;
+
+        }
+
+    }
+
+    *startTime = recording->nameTime - (double)samplesBeforeNameTime / sampleRate;
+
+    return false;
+
+}
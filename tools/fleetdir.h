@@ -0,0 +1,49 @@
+/****************************************************************************
+ * fleetdir.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef FLEETDIR_H_
+#define FLEETDIR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FLEET_MAXIMUM_NAME_LENGTH           256
+#define FLEET_MAXIMUM_PATH_LENGTH           1024
+
+/* Recordings are named by a time as eight hexadecimal digits, in folders named MM_YYYY. This is the start of a scheduled */
+/* recording, but the time the pair was analysed for a detection recording, which the untrimmed recording ends at */
+
+#define FLEET_FOLDER_NAME_LENGTH            7
+#define FLEET_RECORDING_NAME_LENGTH         12
+
+typedef struct {
+    char name[FLEET_RECORDING_NAME_LENGTH + 1];
+    char folder[FLEET_FOLDER_NAME_LENGTH + 1];
+    uint32_t nameTime;
+} fleetRecording_t;
+
+typedef struct {
+    char name[FLEET_MAXIMUM_NAME_LENGTH];
+    fleetRecording_t *recordings;
+    uint32_t numberOfRecordings;
+} fleetDevice_t;
+
+/* Read the card dump of each device in a fleet directory, with the recordings of each sorted by the time in their name. Returns false if the directory cannot be read */
+
+bool readFleetDirectory(const char *directory, fleetDevice_t **devices, uint32_t *numberOfDevices);
+
+void freeFleetDirectory(fleetDevice_t *devices, uint32_t numberOfDevices);
+
+void getFleetRecordingPath(const char *directory, const fleetDevice_t *device, const fleetRecording_t *recording, char *path, uint32_t length);
+
+/* Start time of a recording of the given length. A detection recording is recognised by the onset chunk written by the */
+/* firmware, and starts from its onset time if known, otherwise from the end of the untrimmed recording at the time in its */
+/* name. Recordings without the chunk are taken to end at the time in their name if namedAtEnd is set, otherwise to start */
+/* there. Returns true if the start was timed from an onset, which is good to a tick of the real time clock */
+
+bool getFleetRecordingStartTime(const char *path, const fleetRecording_t *recording, uint32_t sampleRate, uint32_t numberOfSamples, bool namedAtEnd, double *startTime);
+
+#endif /* FLEETDIR_H_ */
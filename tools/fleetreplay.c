@@ -0,0 +1,787 @@
+/****************************************************************************
+ * fleetreplay.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Re-analyses the SD card dumps of a whole fleet. Each subdirectory of the
+ * fleet directory is one device, holding the MM_YYYY folders written by
+ * the firmware, in which each recording is named by a time in hexadecimal
+ * seconds. This is the start of a scheduled recording, while a detection
+ * recording is placed by its onset chunk as in tdoalocate. The recordings
+ * of each device are replayed in time order as one stream through the
+ * firmware front-end and the detection models, in the overlapping pairs of
+ * two second buffers analysed by the listening loop. Recordings at 16, 32
+ * or 48kHz are decimated to 8kHz first.
+ *
+ * Each device keeps its own context, holding the last buffer, any partial
+ * buffer, the decimator history and the decoders. When a recording starts
+ * where the previous one ended the context carries on, so pairs spanning
+ * the boundary are analysed as they would have been on the device.
+ * Otherwise the context starts again.
+ *
+ * Devices are scheduled on a work-stealing pool. A device is always in at
+ * most one worker queue, and a worker takes one recording from a device
+ * before returning it to the back of its own queue, from which idle
+ * workers steal the device at the front.
+ *
+ * Progress is appended to a checkpoint journal after each recording, so a
+ * run which is stopped can be resumed with the same journal, and the
+ * events are written as one table sorted by time.
+ *
+ * Build: cc -O3 -march=native -Ihost -I../inc -o fleetreplay fleetreplay.c fleetdir.c batchhmm.c wavfile.c ../src/decimator.c ../src/detector.c ../src/hmm.c ../src/models.c ../src/modelfile.c -lm -lpthread
+ * Usage: fleetreplay [-j threads] [-c checkpoint.txt] [-o events.csv] [-m MODEL.BIN] fleetDirectory
+ *****************************************************************************/
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+
+#include "detector.h"
+#include "models.h"
+#include "decimator.h"
+#include "batchhmm.h"
+#include "wavfile.h"
+#include "fleetdir.h"
+
+#define SAMPLE_RATE                         DETECTOR_SAMPLE_RATE
+#define BUFFER_SIZE                         DETECTOR_BUFFER_SIZE
+
+#define DEFAULT_CHECKPOINT                  "replay.chk"
+#define DEFAULT_OUTPUT                      "events.csv"
+
+#define MAXIMUM_NUMBER_OF_THREADS           256
+
+/* Samples at the detector rate decimated in each block, as in a DMA transfer */
+
+#define DECIMATION_BLOCK_SIZE               128
+
+/* Recordings starting within this many seconds of the end of the previous one continue its stream */
+
+#define CONTINUITY_TOLERANCE                1
+
+typedef struct {
+    uint32_t fileIndex;
+    uint32_t offset;
+} bufferOrigin_t;
+
+typedef struct {
+    uint32_t device;
+    uint32_t fileIndex;
+    uint32_t offset;
+    double time;
+    uint32_t detections;
+} event_t;
+
+/* Stream state of one device, kept between its recordings */
+
+typedef struct {
+    const fleetDevice_t *card;
+    uint32_t nextRecording;
+    uint32_t currentRecording;
+    bool active;
+    uint32_t factor;
+    double segmentStartTime;
+    uint64_t segmentSamples;
+    double expectedStartTime;
+    decimator_t decimator;
+    int16_t buffers[2][BUFFER_SIZE];
+    bufferOrigin_t origins[2];
+    uint32_t currentBuffer;
+    uint32_t bufferIndex;
+    bool havePreviousBuffer;
+    batchDecoder_t *decoders[MAXIMUM_NUMBER_OF_DETECTOR_MODELS];
+    event_t pending[BATCH_HMM_LANES];
+    uint32_t numberOfLanesUsed;
+} device_t;
+
+/* Double ended queue of devices. The owner works at the back and thieves take from the front */
+
+typedef struct {
+    pthread_mutex_t mutex;
+    uint32_t *devices;
+    uint32_t front;
+    uint32_t back;
+} taskQueue_t;
+
+typedef struct {
+    uint32_t index;
+    uint32_t recordingsProcessed;
+    uint32_t steals;
+} worker_t;
+
+static const char *fleetDirectory;
+
+static fleetDevice_t *cards;
+
+static device_t *devices;
+
+static uint32_t numberOfDevices;
+
+static taskQueue_t *queues;
+
+static uint32_t numberOfThreads;
+
+static volatile uint32_t remainingDevices;
+
+/* Events found so far, and the checkpoint journal */
+
+static pthread_mutex_t eventMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static event_t *events;
+
+static uint32_t numberOfEvents;
+
+static uint32_t eventCapacity;
+
+static FILE *journal;
+
+static modelFile_t modelFile;
+
+static double getSeconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+
+}
+
+static int loadModelFile(const char *filename) {
+
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL) return 1;
+
+    size_t bytesRead = fread(&modelFile, 1, sizeof(modelFile_t), file);
+
+    fclose(file);
+
+    return bytesRead != sizeof(modelFile_t) || !loadDetectorModels(&modelFile);
+
+}
+
+/* Events and the checkpoint journal */
+
+static void addEvent(const event_t *event) {
+
+    if (numberOfEvents == eventCapacity) {
+
+        eventCapacity = eventCapacity == 0 ? 1024 : 2 * eventCapacity;
+
+        events = realloc(events, eventCapacity * sizeof(event_t));
+
+    }
+
+    events[numberOfEvents++] = *event;
+
+}
+
+static int32_t findDevice(const char *name) {
+
+    for (uint32_t i = 0; i < numberOfDevices; i += 1) {
+
+        if (strcmp(devices[i].card->name, name) == 0) return i;
+
+    }
+
+    return -1;
+
+}
+
+/* Journal lines record each event with the recording being replayed when it was found, which is later than the recording it */
+/* starts in for a pair across a file boundary, then the completion of that recording. Recordings complete in order, so each */
+/* device resumes after its last completed recording, keeping only the events journalled before its last completion */
+
+static void readJournal(const char *filename) {
+
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL) return;
+
+    char line[FLEET_MAXIMUM_PATH_LENGTH];
+
+    event_t *found = NULL;
+
+    uint32_t numberOfFound = 0;
+
+    uint32_t *numberOfCompletedEvents = calloc(numberOfDevices, sizeof(uint32_t));
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+
+        char name[FLEET_MAXIMUM_NAME_LENGTH];
+
+        event_t event;
+
+        uint32_t foundIn;
+
+        if (sscanf(line, "event %255s %u %u %u %lf %u", name, &foundIn, &event.fileIndex, &event.offset, &event.time, &event.detections) == 6) {
+
+            int32_t device = findDevice(name);
+
+            if (device < 0) continue;
+
+            event.device = device;
+
+            found = realloc(found, (numberOfFound + 1) * sizeof(event_t));
+
+            found[numberOfFound++] = event;
+
+        } else if (sscanf(line, "done %255s %u", name, &event.fileIndex) == 2) {
+
+            int32_t device = findDevice(name);
+
+            if (device < 0) continue;
+
+            if (event.fileIndex + 1 > devices[device].nextRecording) devices[device].nextRecording = event.fileIndex + 1;
+
+            numberOfCompletedEvents[device] = numberOfFound;
+
+        }
+
+    }
+
+    fclose(file);
+
+    for (uint32_t i = 0; i < numberOfFound; i += 1) {
+
+        if (i < numberOfCompletedEvents[found[i].device]) addEvent(found + i);
+
+    }
+
+    free(numberOfCompletedEvents);
+
+    free(found);
+
+}
+
+static int compareEvents(const void *a, const void *b) {
+
+    const event_t *first = a, *second = b;
+
+    if (first->time != second->time) return first->time < second->time ? -1 : 1;
+
+    return first->device < second->device ? -1 : first->device > second->device;
+
+}
+
+static int writeEvents(const char *filename) {
+
+    qsort(events, numberOfEvents, sizeof(event_t), compareEvents);
+
+    FILE *file = fopen(filename, "w");
+
+    if (file == NULL) return 1;
+
+    fprintf(file, "time,device,recording,offset,models\n");
+
+    for (uint32_t i = 0; i < numberOfEvents; i += 1) {
+
+        event_t *event = events + i;
+
+        device_t *device = devices + event->device;
+
+        fleetRecording_t *recording = device->card->recordings + event->fileIndex;
+
+        /* Round to the millisecond before splitting off the seconds, so a time just before a minute does not print as 60 seconds */
+
+        uint64_t milliseconds = (uint64_t)(event->time * 1000.0 + 0.5);
+
+        time_t seconds = milliseconds / 1000;
+
+        struct tm time;
+
+        gmtime_r(&seconds, &time);
+
+        fprintf(file, "%04d-%02d-%02dT%02d:%02d:%02d.%03uZ,%s,%s/%s,%.3f,", 1900 + time.tm_year, 1 + time.tm_mon, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec, (unsigned int)(milliseconds % 1000), device->card->name, recording->folder, recording->name, (double)event->offset / SAMPLE_RATE);
+
+        bool first = true;
+
+        for (uint32_t j = 0; j < numberOfDetectorModels; j += 1) {
+
+            if ((event->detections & (1 << j)) == 0) continue;
+
+            fprintf(file, "%s%.*s", first ? "" : " ", HMM_MODEL_NAME_LENGTH, detectorModels[j]->name);
+
+            first = false;
+
+        }
+
+        fprintf(file, "\n");
+
+    }
+
+    return fclose(file) != 0;
+
+}
+
+/* Device streams */
+
+static void resetStream(device_t *device, uint32_t factor, double startTime) {
+
+    device->active = true;
+
+    device->factor = factor;
+
+    device->segmentStartTime = startTime;
+
+    device->segmentSamples = 0;
+
+    device->currentBuffer = 0;
+
+    device->bufferIndex = 0;
+
+    device->havePreviousBuffer = false;
+
+    initialiseDecimator(&device->decimator, factor, DECIMATION_BLOCK_SIZE * factor);
+
+}
+
+/* Decode the pairs waiting in the lanes and record any events */
+
+static void flushDevice(device_t *device) {
+
+    if (device->numberOfLanesUsed == 0) return;
+
+    int16_t detectionFrames[BATCH_HMM_LANES];
+
+    for (uint32_t i = 0; i < numberOfDetectorModels; i += 1) {
+
+        decodeBatch(device->decoders[i], getNumberOfFeatureFrames(), detectionFrames);
+
+        for (uint32_t lane = 0; lane < device->numberOfLanesUsed; lane += 1) {
+
+            if (detectionFrames[lane] >= detectorModels[i]->minimumDetectionFrames && detectionFrames[lane] <= detectorModels[i]->maximumDetectionFrames) device->pending[lane].detections |= 1 << i;
+
+        }
+
+    }
+
+    pthread_mutex_lock(&eventMutex);
+
+    for (uint32_t lane = 0; lane < device->numberOfLanesUsed; lane += 1) {
+
+        event_t *event = device->pending + lane;
+
+        if (event->detections == 0) continue;
+
+        addEvent(event);
+
+        fprintf(journal, "event %s %u %u %u %.6f %u\n", device->card->name, device->currentRecording, event->fileIndex, event->offset, event->time, event->detections);
+
+    }
+
+    pthread_mutex_unlock(&eventMutex);
+
+    device->numberOfLanesUsed = 0;
+
+}
+
+/* Extract the features of the previous and current buffers into the next lane */
+
+static void analysePair(device_t *device) {
+
+    uint32_t numberOfBands = getNumberOfFeatureBands();
+
+    uint32_t numberOfFrames = getNumberOfFeatureFrames();
+
+    static __thread float *values[HMM_MAXIMUM_FEATURES];
+
+    static __thread float *features;
+
+    if (features == NULL) {
+
+        features = malloc(numberOfBands * numberOfFrames * sizeof(float));
+
+        for (uint32_t band = 0; band < numberOfBands; band += 1) values[band] = features + band * numberOfFrames;
+
+    }
+
+    uint32_t previous = device->currentBuffer ^ 1;
+
+    extractFeatures(device->buffers[previous], device->buffers[device->currentBuffer], values);
+
+    for (uint32_t i = 0; i < numberOfDetectorModels; i += 1) setBatchStream(device->decoders[i], device->numberOfLanesUsed, values, numberOfFrames);
+
+    event_t *event = device->pending + device->numberOfLanesUsed++;
+
+    event->device = device - devices;
+
+    event->fileIndex = device->origins[previous].fileIndex;
+
+    event->offset = device->origins[previous].offset;
+
+    event->time = device->segmentStartTime + (double)(device->segmentSamples - 2 * BUFFER_SIZE) / SAMPLE_RATE;
+
+    event->detections = 0;
+
+    if (device->numberOfLanesUsed == BATCH_HMM_LANES) flushDevice(device);
+
+}
+
+/* Add decimated samples to the buffers, analysing each pair of consecutive buffers unless priming the context on resume */
+
+static void addSamples(device_t *device, const int16_t *samples, uint32_t numberOfSamples, uint32_t fileIndex, uint32_t offset, bool priming) {
+
+    for (uint32_t i = 0; i < numberOfSamples; ) {
+
+        if (device->bufferIndex == 0) {
+
+            device->origins[device->currentBuffer].fileIndex = fileIndex;
+
+            device->origins[device->currentBuffer].offset = offset + i;
+
+        }
+
+        uint32_t count = BUFFER_SIZE - device->bufferIndex < numberOfSamples - i ? BUFFER_SIZE - device->bufferIndex : numberOfSamples - i;
+
+        memcpy(device->buffers[device->currentBuffer] + device->bufferIndex, samples + i, count * sizeof(int16_t));
+
+        device->bufferIndex += count;
+
+        device->segmentSamples += count;
+
+        i += count;
+
+        if (device->bufferIndex < BUFFER_SIZE) break;
+
+        if (device->havePreviousBuffer && !priming) analysePair(device);
+
+        device->havePreviousBuffer = true;
+
+        device->currentBuffer ^= 1;
+
+        device->bufferIndex = 0;
+
+    }
+
+}
+
+static void replayRecording(device_t *device, uint32_t fileIndex, bool priming) {
+
+    fleetRecording_t *recording = device->card->recordings + fileIndex;
+
+    device->currentRecording = fileIndex;
+
+    char path[FLEET_MAXIMUM_PATH_LENGTH];
+
+    getFleetRecordingPath(fleetDirectory, device->card, recording, path, sizeof(path));
+
+    uint32_t sampleRate, numberOfSamples;
+
+    int16_t *samples = readWavFile(path, &sampleRate, &numberOfSamples);
+
+    uint32_t factor = sampleRate / SAMPLE_RATE;
+
+    if (samples == NULL || sampleRate % SAMPLE_RATE != 0 || factor < 1 || factor > DECIMATOR_MAXIMUM_FACTOR) {
+
+        fprintf(stderr, "Skipping %s, not a 16-bit mono WAV file at a multiple of 8kHz\n", path);
+
+        device->active = false;
+
+        free(samples);
+
+        return;
+
+    }
+
+    /* Continue the stream only if this recording follows on from the last at the same rate */
+
+    double duration = (double)numberOfSamples / sampleRate;
+
+    double startTime;
+
+    getFleetRecordingStartTime(path, recording, sampleRate, numberOfSamples, false, &startTime);
+
+    bool continuous = device->active && device->factor == factor && startTime >= device->expectedStartTime - CONTINUITY_TOLERANCE && startTime <= device->expectedStartTime + CONTINUITY_TOLERANCE;
+
+    if (!continuous) resetStream(device, factor, startTime);
+
+    device->expectedStartTime = startTime + duration;
+
+    if (device->decoders[0] == NULL) {
+
+        for (uint32_t i = 0; i < numberOfDetectorModels; i += 1) device->decoders[i] = createBatchDecoder(detectorModels[i]);
+
+    }
+
+    /* Decimate in blocks the size of a DMA transfer, dropping any final partial block */
+
+    uint32_t blockSize = DECIMATION_BLOCK_SIZE * factor;
+
+    int16_t decimated[DECIMATION_BLOCK_SIZE];
+
+    for (uint32_t start = 0; start + blockSize <= numberOfSamples; start += blockSize) {
+
+        const int16_t *block = samples + start;
+
+        if (factor > 1) {
+
+            decimate(&device->decimator, samples + start, decimated, blockSize);
+
+            block = decimated;
+
+        }
+
+        addSamples(device, block, DECIMATION_BLOCK_SIZE, fileIndex, start / factor, priming);
+
+    }
+
+    free(samples);
+
+    if (priming) return;
+
+    flushDevice(device);
+
+    pthread_mutex_lock(&eventMutex);
+
+    fprintf(journal, "done %s %u\n", device->card->name, fileIndex);
+
+    fflush(journal);
+
+    pthread_mutex_unlock(&eventMutex);
+
+}
+
+/* Work-stealing pool */
+
+static void pushDevice(taskQueue_t *queue, uint32_t device) {
+
+    pthread_mutex_lock(&queue->mutex);
+
+    queue->devices[queue->back++ % numberOfDevices] = device;
+
+    pthread_mutex_unlock(&queue->mutex);
+
+}
+
+static bool popDevice(taskQueue_t *queue, uint32_t *device, bool fromFront) {
+
+    bool found = false;
+
+    pthread_mutex_lock(&queue->mutex);
+
+    if (queue->front != queue->back) {
+
+        *device = fromFront ? queue->devices[queue->front++ % numberOfDevices] : queue->devices[--queue->back % numberOfDevices];
+
+        found = true;
+
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return found;
+
+}
+
+static void* workerThread(void *argument) {
+
+    worker_t *worker = argument;
+
+    taskQueue_t *ownQueue = queues + worker->index;
+
+    while (__atomic_load_n(&remainingDevices, __ATOMIC_ACQUIRE) > 0) {
+
+        uint32_t index;
+
+        bool found = popDevice(ownQueue, &index, false);
+
+        for (uint32_t i = 1; i < numberOfThreads && !found; i += 1) {
+
+            found = popDevice(queues + (worker->index + i) % numberOfThreads, &index, true);
+
+            worker->steals += found;
+
+        }
+
+        if (!found) {
+
+            sched_yield();
+
+            continue;
+
+        }
+
+        device_t *device = devices + index;
+
+        replayRecording(device, device->nextRecording++, false);
+
+        worker->recordingsProcessed += 1;
+
+        if (device->nextRecording < device->card->numberOfRecordings) {
+
+            pushDevice(ownQueue, index);
+
+        } else {
+
+            __atomic_sub_fetch(&remainingDevices, 1, __ATOMIC_RELEASE);
+
+        }
+
+    }
+
+    return NULL;
+
+}
+
+int main(int argc, char **argv) {
+
+    const char *checkpointFilename = DEFAULT_CHECKPOINT;
+
+    const char *outputFilename = DEFAULT_OUTPUT;
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    numberOfThreads = processors > 0 ? processors : 1;
+
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+
+        if (strcmp(argv[i], "-j") == 0) {
+
+            numberOfThreads = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-c") == 0) {
+
+            checkpointFilename = argv[i + 1];
+
+        } else if (strcmp(argv[i], "-o") == 0) {
+
+            outputFilename = argv[i + 1];
+
+        } else if (strcmp(argv[i], "-m") == 0) {
+
+            if (loadModelFile(argv[i + 1])) {
+
+                fprintf(stderr, "%s is not a valid model file for this Goertzel bank\n", argv[i + 1]);
+
+                return 1;
+
+            }
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    if (numberOfThreads < 1) numberOfThreads = 1;
+
+    if (numberOfThreads > MAXIMUM_NUMBER_OF_THREADS) numberOfThreads = MAXIMUM_NUMBER_OF_THREADS;
+
+    if (i + 1 != argc) {
+
+        fprintf(stderr, "Usage: %s [-j threads] [-c checkpoint.txt] [-o events.csv] [-m MODEL.BIN] fleetDirectory\n", argv[0]);
+
+        return 1;
+
+    }
+
+    fleetDirectory = argv[i];
+
+    if (!readFleetDirectory(fleetDirectory, &cards, &numberOfDevices)) {
+
+        fprintf(stderr, "Could not read %s\n", fleetDirectory);
+
+        return 1;
+
+    }
+
+    devices = calloc(numberOfDevices, sizeof(device_t));
+
+    for (uint32_t j = 0; j < numberOfDevices; j += 1) devices[j].card = cards + j;
+
+    /* Resume from the journal, priming each context with the last completed recording */
+
+    readJournal(checkpointFilename);
+
+    journal = fopen(checkpointFilename, "a");
+
+    if (journal == NULL) {
+
+        fprintf(stderr, "Could not write %s\n", checkpointFilename);
+
+        return 1;
+
+    }
+
+    uint32_t numberOfRecordings = 0, numberOfResumed = 0;
+
+    queues = calloc(numberOfThreads, sizeof(taskQueue_t));
+
+    for (uint32_t j = 0; j < numberOfThreads; j += 1) {
+
+        pthread_mutex_init(&queues[j].mutex, NULL);
+
+        queues[j].devices = malloc((numberOfDevices + 1) * sizeof(uint32_t));
+
+    }
+
+    for (uint32_t j = 0; j < numberOfDevices; j += 1) {
+
+        device_t *device = devices + j;
+
+        numberOfRecordings += device->card->numberOfRecordings;
+
+        numberOfResumed += device->nextRecording;
+
+        if (device->nextRecording >= device->card->numberOfRecordings) continue;
+
+        if (device->nextRecording > 0) replayRecording(device, device->nextRecording - 1, true);
+
+        pushDevice(queues + remainingDevices % numberOfThreads, j);
+
+        remainingDevices += 1;
+
+    }
+
+    fprintf(stderr, "%u devices, %u recordings, %u already replayed\n", numberOfDevices, numberOfRecordings, numberOfResumed);
+
+    /* Replay the remaining recordings */
+
+    double startTime = getSeconds();
+
+    pthread_t threads[MAXIMUM_NUMBER_OF_THREADS];
+
+    worker_t workers[MAXIMUM_NUMBER_OF_THREADS];
+
+    for (uint32_t j = 0; j < numberOfThreads; j += 1) {
+
+        workers[j] = (worker_t){.index = j};
+
+        pthread_create(threads + j, NULL, workerThread, workers + j);
+
+    }
+
+    for (uint32_t j = 0; j < numberOfThreads; j += 1) {
+
+        pthread_join(threads[j], NULL);
+
+        fprintf(stderr, "Worker %u: %u recordings, %u steals\n", j, workers[j].recordingsProcessed, workers[j].steals);
+
+    }
+
+    fclose(journal);
+
+    fprintf(stderr, "Replayed in %.2f seconds, %u events\n", getSeconds() - startTime, numberOfEvents);
+
+    if (writeEvents(outputFilename)) {
+
+        fprintf(stderr, "Could not write %s\n", outputFilename);
+
+        return 1;
+
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,331 @@
+/****************************************************************************
+ * goertzelbench.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Compares the throughput of the firmware Goertzel bank, run one pair of
+ * buffers at a time by extractFeatures(), with the lane-parallel bank in
+ * batchgoertzel.c on a single core. The pairs are taken from 8kHz WAV files,
+ * or are synthetic noise and tone bursts if no files are given. Each path
+ * is timed over several repeats and the fastest is reported in samples per
+ * second.
+ *
+ * The amplitudes of the two paths are compared, and the pairs are decoded
+ * with the first detection model by calculate() and by the batch decoder
+ * to check that the detections agree.
+ *
+ * Build: cc -O3 -march=native -Ihost -I../inc -o goertzelbench goertzelbench.c batchgoertzel.c batchhmm.c wavfile.c ../src/detector.c ../src/hmm.c ../src/models.c ../src/modelfile.c -lm
+ * Usage: goertzelbench [-n seconds] [-r repeats] [file.wav ...]
+ *****************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "detector.h"
+#include "models.h"
+#include "batchgoertzel.h"
+#include "wavfile.h"
+
+#define SAMPLE_RATE                         DETECTOR_SAMPLE_RATE
+#define BUFFER_SIZE                         DETECTOR_BUFFER_SIZE
+#define SAMPLE_COUNT                        (2 * BUFFER_SIZE)
+
+#define DEFAULT_SYNTHETIC_SECONDS           3600
+#define DEFAULT_REPEATS                     5
+
+#define MAXIMUM_NUMBER_OF_BANDS             16
+
+/* Synthetic audio is noise with a tone burst in one pair in eight */
+
+#define NOISE_AMPLITUDE                     200
+#define BURST_AMPLITUDE                     8000.0f
+#define BURST_LENGTH                        2000
+#define BURST_FREQUENCY                     1300.0f
+#define BURST_PERIOD                        8
+
+static double getSeconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+
+}
+
+/* Fill the pairs from the WAV files, repeating them if there are fewer samples than pairs, or with synthetic audio */
+
+static void fillPairs(int16_t *pairs, uint32_t numberOfPairs, int numberOfFiles, char **filenames) {
+
+    uint32_t filled = 0;
+
+    for (int i = 0; i < numberOfFiles && filled < numberOfPairs; i += 1) {
+
+        uint32_t sampleRate, numberOfSamples;
+
+        int16_t *samples = readWavFile(filenames[i], &sampleRate, &numberOfSamples);
+
+        if (samples == NULL || sampleRate != SAMPLE_RATE) {
+
+            fprintf(stderr, "Skipping %s, not a 16-bit mono 8kHz WAV file\n", filenames[i]);
+
+        } else {
+
+            for (uint32_t start = 0; start + SAMPLE_COUNT <= numberOfSamples && filled < numberOfPairs; start += SAMPLE_COUNT) {
+
+                memcpy(pairs + (size_t)filled++ * SAMPLE_COUNT, samples + start, SAMPLE_COUNT * sizeof(int16_t));
+
+            }
+
+        }
+
+        free(samples);
+
+    }
+
+    if (filled > 0) {
+
+        for (uint32_t i = filled; i < numberOfPairs; i += 1) memcpy(pairs + (size_t)i * SAMPLE_COUNT, pairs + (size_t)(i % filled) * SAMPLE_COUNT, SAMPLE_COUNT * sizeof(int16_t));
+
+        return;
+
+    }
+
+    uint32_t seed = 1;
+
+    for (uint32_t i = 0; i < numberOfPairs; i += 1) {
+
+        int16_t *pair = pairs + (size_t)i * SAMPLE_COUNT;
+
+        for (uint32_t j = 0; j < SAMPLE_COUNT; j += 1) {
+
+            seed = seed * 1664525 + 1013904223;
+
+            float value = (int32_t)(seed >> 16) % (2 * NOISE_AMPLITUDE + 1) - NOISE_AMPLITUDE;
+
+            if (i % BURST_PERIOD == 0 && j >= BUFFER_SIZE && j < BUFFER_SIZE + BURST_LENGTH) {
+
+                value += BURST_AMPLITUDE * sinf(2.0f * M_PI * BURST_FREQUENCY * j / SAMPLE_RATE) * (1.0f - (float)(j - BUFFER_SIZE) / BURST_LENGTH);
+
+            }
+
+            pair[j] = (int16_t)value;
+
+        }
+
+    }
+
+}
+
+int main(int argc, char **argv) {
+
+    uint32_t seconds = DEFAULT_SYNTHETIC_SECONDS;
+
+    uint32_t repeats = DEFAULT_REPEATS;
+
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+
+        if (strcmp(argv[i], "-n") == 0) {
+
+            seconds = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-r") == 0) {
+
+            repeats = strtoul(argv[i + 1], NULL, 10);
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    if ((i < argc && argv[i][0] == '-') || repeats < 1) {
+
+        fprintf(stderr, "Usage: %s [-n seconds] [-r repeats] [file.wav ...]\n", argv[0]);
+
+        return 1;
+
+    }
+
+    uint32_t numberOfBands = getNumberOfFeatureBands();
+
+    uint32_t numberOfFrames = getNumberOfFeatureFrames();
+
+    /* Round the number of pairs up to whole batches */
+
+    uint32_t numberOfBatches = (seconds * SAMPLE_RATE / SAMPLE_COUNT + BATCH_HMM_LANES - 1) / BATCH_HMM_LANES;
+
+    if (numberOfBatches < 1) numberOfBatches = 1;
+
+    uint32_t numberOfPairs = numberOfBatches * BATCH_HMM_LANES;
+
+    int16_t *pairs = malloc((size_t)numberOfPairs * SAMPLE_COUNT * sizeof(int16_t));
+
+    float *scalarValues = malloc((size_t)numberOfPairs * numberOfBands * numberOfFrames * sizeof(float));
+
+    batchLanes_t *batchValues = NULL;
+
+    if (pairs == NULL || scalarValues == NULL || posix_memalign((void**)&batchValues, sizeof(batchLanes_t), (size_t)numberOfBatches * numberOfBands * numberOfFrames * sizeof(batchLanes_t)) != 0) {
+
+        fprintf(stderr, "Could not allocate %u pairs\n", numberOfPairs);
+
+        return 1;
+
+    }
+
+    fillPairs(pairs, numberOfPairs, argc - i, argv + i);
+
+    double totalSamples = (double)numberOfPairs * SAMPLE_COUNT;
+
+    /* Scalar bank, one pair at a time */
+
+    float *values[MAXIMUM_NUMBER_OF_BANDS];
+
+    double scalarTime = INFINITY;
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat += 1) {
+
+        double startTime = getSeconds();
+
+        for (uint32_t pair = 0; pair < numberOfPairs; pair += 1) {
+
+            for (uint32_t band = 0; band < numberOfBands; band += 1) values[band] = scalarValues + ((size_t)pair * numberOfBands + band) * numberOfFrames;
+
+            int16_t *samples = pairs + (size_t)pair * SAMPLE_COUNT;
+
+            extractFeatures(samples, samples + BUFFER_SIZE, values);
+
+        }
+
+        double elapsed = getSeconds() - startTime;
+
+        if (elapsed < scalarTime) scalarTime = elapsed;
+
+    }
+
+    /* Batch bank, one pair in each lane */
+
+    const int16_t *streams[BATCH_HMM_LANES];
+
+    batchLanes_t *lanes[MAXIMUM_NUMBER_OF_BANDS];
+
+    double batchTime = INFINITY;
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat += 1) {
+
+        double startTime = getSeconds();
+
+        for (uint32_t batch = 0; batch < numberOfBatches; batch += 1) {
+
+            for (uint32_t lane = 0; lane < BATCH_HMM_LANES; lane += 1) streams[lane] = pairs + ((size_t)batch * BATCH_HMM_LANES + lane) * SAMPLE_COUNT;
+
+            for (uint32_t band = 0; band < numberOfBands; band += 1) lanes[band] = batchValues + ((size_t)batch * numberOfBands + band) * numberOfFrames;
+
+            extractBatchFeatures(streams, SAMPLE_COUNT, lanes);
+
+        }
+
+        double elapsed = getSeconds() - startTime;
+
+        if (elapsed < batchTime) batchTime = elapsed;
+
+    }
+
+    printf("%u pairs, %.0f samples, best of %u repeats on one core\n", numberOfPairs, totalSamples, repeats);
+
+    printf("Scalar Goertzel:            %8.2f Msamples/s\n", totalSamples / scalarTime / 1e6);
+
+    printf("Batch Goertzel (%2u lanes):  %8.2f Msamples/s, %.1f times faster\n", BATCH_HMM_LANES, totalSamples / batchTime / 1e6, scalarTime / batchTime);
+
+    /* Compare the amplitudes relative to the largest in each band */
+
+    double largestDifference = 0.0;
+
+    uint64_t identical = 0;
+
+    for (uint32_t batch = 0; batch < numberOfBatches; batch += 1) {
+
+        for (uint32_t band = 0; band < numberOfBands; band += 1) {
+
+            for (uint32_t t = 0; t < numberOfFrames; t += 1) {
+
+                for (uint32_t lane = 0; lane < BATCH_HMM_LANES; lane += 1) {
+
+                    uint32_t pair = batch * BATCH_HMM_LANES + lane;
+
+                    float scalar = scalarValues[((size_t)pair * numberOfBands + band) * numberOfFrames + t];
+
+                    float batched = batchValues[((size_t)batch * numberOfBands + band) * numberOfFrames + t][lane];
+
+                    double difference = fabs(scalar - batched) / (fabs(scalar) > 1e-6 ? fabs(scalar) : 1e-6);
+
+                    if (difference > largestDifference) largestDifference = difference;
+
+                    identical += scalar == batched;
+
+                }
+
+            }
+
+        }
+
+    }
+
+    printf("Amplitudes identical: %llu of %llu, largest relative difference %.3g\n", (unsigned long long)identical, (unsigned long long)numberOfPairs * numberOfBands * numberOfFrames, largestDifference);
+
+    /* Decode both sets of features with the first model */
+
+    const hmmModel_t *model = detectorModels[0];
+
+    batchDecoder_t *decoder = createBatchDecoder(model);
+
+    uint32_t agreements = 0, detections = 0;
+
+    int16_t detectionFrames[BATCH_HMM_LANES];
+
+    for (uint32_t batch = 0; batch < numberOfBatches; batch += 1) {
+
+        for (uint32_t band = 0; band < numberOfBands; band += 1) lanes[band] = batchValues + ((size_t)batch * numberOfBands + band) * numberOfFrames;
+
+        setBatchFeatures(decoder, lanes, numberOfFrames);
+
+        decodeBatch(decoder, numberOfFrames, detectionFrames);
+
+        for (uint32_t lane = 0; lane < BATCH_HMM_LANES; lane += 1) {
+
+            uint32_t pair = batch * BATCH_HMM_LANES + lane;
+
+            for (uint32_t band = 0; band < numberOfBands; band += 1) values[band] = scalarValues + ((size_t)pair * numberOfBands + band) * numberOfFrames;
+
+            int16_t scalarFrames = calculate(model, values, numberOfFrames);
+
+            bool scalarDetection = scalarFrames >= model->minimumDetectionFrames && scalarFrames <= model->maximumDetectionFrames;
+
+            bool batchDetection = detectionFrames[lane] >= model->minimumDetectionFrames && detectionFrames[lane] <= model->maximumDetectionFrames;
+
+            agreements += scalarDetection == batchDetection;
+
+            detections += scalarDetection;
+
+        }
+
+    }
+
+    printf("%.*s detections agree on %u of %u pairs, %u detections\n", HMM_MODEL_NAME_LENGTH, model->name, agreements, numberOfPairs, detections);
+
+    destroyBatchDecoder(decoder);
+
+    free(batchValues);
+    free(scalarValues);
+    free(pairs);
+
+    return agreements != numberOfPairs;
+
+}
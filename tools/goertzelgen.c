@@ -0,0 +1,201 @@
+/****************************************************************************
+ * goertzelgen.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Generates inc/goertzelbank.h, the Goertzel filter bank used by the
+ * detector, from a list of band frequencies and the sample rate. The header
+ * holds the band frequencies and coefficients, the scaled Hamming window
+ * and macros which update, output and reset every band with the loop over
+ * bands unrolled.
+ *
+ * The default phase of -1 radian and scale of 2^-14 reproduce the window
+ * the shipped model was trained with.
+ *
+ * Build: cc -O2 -o goertzelgen goertzelgen.c -lm
+ * Usage: goertzelgen [-r sampleRate] [-w windowLength] [-p phase] [-s scaleBits] frequency ... > ../inc/goertzelbank.h
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXIMUM_NUMBER_OF_BANDS             16
+#define MAXIMUM_WINDOW_LENGTH               1024
+
+#define DEFAULT_SAMPLE_RATE                 8000
+#define DEFAULT_WINDOW_LENGTH               128
+#define DEFAULT_PHASE                       -1.0
+#define DEFAULT_SCALE_BITS                  14
+
+#define WINDOW_VALUES_PER_LINE              4
+
+static void printMacro(const char *name, const char *format, unsigned int numberOfBands) {
+
+    printf("#define %s", name);
+
+    for (unsigned int i = 0; i < numberOfBands; i += 1) {
+
+        printf(" \\\n    ");
+
+        printf(format, i, i, i, i, i, i, i, i);
+
+    }
+
+    printf("\n\n");
+
+}
+
+int main(int argc, char **argv) {
+
+    unsigned int sampleRate = DEFAULT_SAMPLE_RATE;
+
+    unsigned int windowLength = DEFAULT_WINDOW_LENGTH;
+
+    double phase = DEFAULT_PHASE;
+
+    unsigned int scaleBits = DEFAULT_SCALE_BITS;
+
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-' && argv[i][1] != '\0' && strchr("rwps", argv[i][1]) != NULL; i += 2) {
+
+        if (strcmp(argv[i], "-r") == 0) {
+
+            sampleRate = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-w") == 0) {
+
+            windowLength = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-p") == 0) {
+
+            phase = atof(argv[i + 1]);
+
+        } else if (strcmp(argv[i], "-s") == 0) {
+
+            scaleBits = strtoul(argv[i + 1], NULL, 10);
+
+        }
+
+    }
+
+    unsigned int numberOfBands = argc - i;
+
+    double frequencies[MAXIMUM_NUMBER_OF_BANDS];
+
+    for (unsigned int j = 0; j < numberOfBands && j < MAXIMUM_NUMBER_OF_BANDS; j += 1) {
+
+        frequencies[j] = atof(argv[i + j]);
+
+    }
+
+    if (numberOfBands == 0 || numberOfBands > MAXIMUM_NUMBER_OF_BANDS || sampleRate == 0 || windowLength < 2 || windowLength > MAXIMUM_WINDOW_LENGTH) {
+
+        fprintf(stderr, "Usage: %s [-r sampleRate] [-w windowLength] [-p phase] [-s scaleBits] frequency ...\n", argv[0]);
+
+        return 1;
+
+    }
+
+    for (unsigned int j = 0; j < numberOfBands; j += 1) {
+
+        if (frequencies[j] <= 0.0 || frequencies[j] >= sampleRate / 2.0) {
+
+            fprintf(stderr, "Band frequency %g Hz is not below the Nyquist frequency\n", frequencies[j]);
+
+            return 1;
+
+        }
+
+    }
+
+    /* Header and geometry */
+
+    printf("/****************************************************************************\n");
+    printf(" * goertzelbank.h\n");
+    printf(" * openacousticdevices.info\n");
+    printf(" *\n");
+    printf(" * Generated by tools/goertzelgen.c, do not edit. Regenerate with:\n");
+    printf(" * goertzelgen -r %u -w %u -p %g -s %u", sampleRate, windowLength, phase, scaleBits);
+
+    for (unsigned int j = 0; j < numberOfBands; j += 1) printf(" %g", frequencies[j]);
+
+    printf("\n *****************************************************************************/\n\n");
+
+    printf("#ifndef GOERTZELBANK_H_\n#define GOERTZELBANK_H_\n\n");
+
+    printf("#define GOERTZEL_SAMPLE_RATE                %u\n", sampleRate);
+    printf("#define GOERTZEL_WINDOW_LENGTH              %u\n", windowLength);
+    printf("#define GOERTZEL_NUMBER_OF_BANDS            %u\n\n", numberOfBands);
+
+    /* Band frequencies and coefficients */
+
+    printf("#define GOERTZEL_BAND_FREQUENCIES           {");
+
+    for (unsigned int j = 0; j < numberOfBands; j += 1) {
+
+        char literal[32];
+
+        snprintf(literal, sizeof(literal), "%.9g", frequencies[j]);
+
+        printf("%s%s%sf", j == 0 ? "" : ", ", literal, strpbrk(literal, ".e") == NULL ? ".0" : "");
+
+    }
+
+    printf("}\n\n");
+
+    for (unsigned int j = 0; j < numberOfBands; j += 1) {
+
+        double coefficient = 2.0 * cos(2.0 * M_PI * frequencies[j] / sampleRate);
+
+        char literal[32];
+
+        snprintf(literal, sizeof(literal), "%.9gf", coefficient);
+
+        printf("#define GOERTZEL_COEFFICIENT_%-14u %-16s/* 2*cos(2*pi*%g/%u) */\n", j, literal, frequencies[j], sampleRate);
+
+    }
+
+    printf("\n#define GOERTZEL_COEFFICIENTS               {");
+
+    for (unsigned int j = 0; j < numberOfBands; j += 1) printf("%sGOERTZEL_COEFFICIENT_%u", j == 0 ? "" : ", ", j);
+
+    printf("}\n");
+
+    /* Hamming window including the sample scale */
+
+    printf("\n/* %u Hamming factors / 2^%u */\n\n", windowLength, scaleBits);
+
+    printf("static float goertzelWindow[GOERTZEL_WINDOW_LENGTH] = {");
+
+    double scale = ldexp(1.0, -(int)scaleBits);
+
+    for (unsigned int j = 0; j < windowLength; j += 1) {
+
+        double factor = (0.54 - 0.46 * cos(2.0 * M_PI * j / windowLength + phase)) * scale;
+
+        printf("%s%.9ef%s", j % WINDOW_VALUES_PER_LINE == 0 ? "\n    " : " ", factor, j + 1 < windowLength ? "," : "");
+
+    }
+
+    printf("\n};\n\n");
+
+    /* Unrolled state, update, output and reset for each band */
+
+    printf("/* Each band keeps its two delayed values in local variables declared by GOERTZEL_BANK_DECLARE */\n\n");
+
+    printMacro("GOERTZEL_BANK_DECLARE()", "float goertzelDelay1_%u = 0.0f, goertzelDelay2_%u = 0.0f;", numberOfBands);
+
+    printMacro("GOERTZEL_BANK_UPDATE(sample)", "{ float y = (sample) + GOERTZEL_COEFFICIENT_%u * goertzelDelay1_%u - goertzelDelay2_%u; goertzelDelay2_%u = goertzelDelay1_%u; goertzelDelay1_%u = y; }", numberOfBands);
+
+    printMacro("GOERTZEL_BANK_OUTPUT(values, index)", "arm_sqrt_f32(goertzelDelay1_%u * goertzelDelay1_%u + goertzelDelay2_%u * goertzelDelay2_%u - goertzelDelay1_%u * goertzelDelay2_%u * GOERTZEL_COEFFICIENT_%u, &values[%u][index]);", numberOfBands);
+
+    printMacro("GOERTZEL_BANK_RESET()", "goertzelDelay1_%u = 0.0f; goertzelDelay2_%u = 0.0f;", numberOfBands);
+
+    printf("#endif /* GOERTZELBANK_H_ */\n");
+
+    return 0;
+
+}
@@ -0,0 +1,870 @@
+/****************************************************************************
+ * hmmtrain.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Trains a detection model on labelled 8kHz recordings. Features are
+ * extracted with the firmware front-end from the same overlapping pairs of
+ * two second buffers that the listening loop analyses, then the model is
+ * refined by Baum-Welch, or by Viterbi training with -v. Each iteration
+ * shards the sequences across threads, which accumulate sufficient
+ * statistics that are reduced before the update.
+ *
+ * The list file has one recording per line, followed by 1 if it contains
+ * the target sound, 0 if it does not, or nothing if it is unlabelled. Pairs
+ * from negative recordings are constrained to the states outside the
+ * detection states, so the model learns that they are background. Pairs
+ * from positive recordings may not all contain the sound, so they and the
+ * unlabelled pairs are left unconstrained. The detection rate on the
+ * labelled recordings is reported before and after training using the
+ * firmware decoder and decision rule.
+ *
+ * The trained model is written as a description for modelgen, and with -s
+ * as a C initialiser for src/models.c.
+ *
+ * Build: cc -O2 -Ihost -I../inc -o hmmtrain hmmtrain.c modeltext.c wavfile.c ../src/detector.c ../src/hmm.c ../src/models.c ../src/modelfile.c -lm -lpthread
+ * Usage: hmmtrain [-i initial.txt] [-n iterations] [-j threads] [-v] [-o model.txt] [-s model.c] list.txt
+ *****************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "detector.h"
+#include "modeltext.h"
+#include "wavfile.h"
+
+#define SAMPLE_RATE                         8000
+#define BUFFER_SIZE                         16000
+
+#define DEFAULT_INITIAL_MODEL               "models/gunshot.txt"
+#define DEFAULT_ITERATIONS                  20
+#define DEFAULT_OUTPUT                      "trained.txt"
+
+#define MAXIMUM_NUMBER_OF_THREADS           256
+#define MAXIMUM_LINE_LENGTH                 1024
+
+/* Smallest amplitude before taking logs, smallest variance, and change in log likelihood per frame at which training stops */
+
+#define MINIMUM_AMPLITUDE                   1e-12f
+#define MINIMUM_VARIANCE                    1e-3
+#define CONVERGENCE_THRESHOLD               1e-5
+
+#define UNLABELLED                          -1
+
+typedef struct {
+    char *filename;
+    int label;
+    uint32_t numberOfSequences;
+    float *bands;
+} trainingFile_t;
+
+typedef struct {
+    double logLikelihood;
+    double initial[HMM_MAXIMUM_STATES];
+    double transitions[HMM_MAXIMUM_STATES][HMM_MAXIMUM_STATES];
+    double transitionOccupancy[HMM_MAXIMUM_STATES];
+    double occupancy[HMM_MAXIMUM_STATES];
+    double sum[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+    double sumOfSquares[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+} statistics_t;
+
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+    statistics_t statistics;
+} shard_t;
+
+/* Training data */
+
+static trainingFile_t *files;
+
+static uint32_t numberOfFiles;
+
+static uint32_t numberOfBands;
+
+static uint32_t numberOfFrames;
+
+static uint32_t numberOfSequences;
+
+static float *observations;
+
+/* States each sequence may occupy, as a bit for each state */
+
+static uint32_t *allowedStates;
+
+/* Model being trained and the training mode */
+
+static hmmModel_t model;
+
+static bool viterbiTraining;
+
+/* Work distribution for feature extraction */
+
+static pthread_mutex_t fileMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t nextFile;
+
+static double getSeconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+
+}
+
+static int readList(const char *filename) {
+
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL) return 1;
+
+    char line[MAXIMUM_LINE_LENGTH];
+
+    uint32_t capacity = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+
+        char path[MAXIMUM_LINE_LENGTH];
+
+        int label = UNLABELLED;
+
+        if (sscanf(line, "%1023s %d", path, &label) < 1 || path[0] == '#') continue;
+
+        if (numberOfFiles == capacity) {
+
+            capacity = capacity == 0 ? 256 : 2 * capacity;
+
+            files = realloc(files, capacity * sizeof(trainingFile_t));
+
+        }
+
+        trainingFile_t *trainingFile = files + numberOfFiles;
+
+        memset(trainingFile, 0, sizeof(trainingFile_t));
+
+        trainingFile->filename = strdup(path);
+
+        trainingFile->label = label < 0 ? UNLABELLED : label > 0;
+
+        numberOfFiles += 1;
+
+    }
+
+    fclose(file);
+
+    return numberOfFiles == 0;
+
+}
+
+/* Extract the features of every pair in each file, taking files from a shared counter */
+
+static void* extractWorker(void *argument) {
+
+    (void)argument;
+
+    float **values = malloc(numberOfBands * sizeof(float*));
+
+    while (true) {
+
+        pthread_mutex_lock(&fileMutex);
+
+        uint32_t index = nextFile++;
+
+        pthread_mutex_unlock(&fileMutex);
+
+        if (index >= numberOfFiles) break;
+
+        trainingFile_t *trainingFile = files + index;
+
+        uint32_t sampleRate, numberOfSamples;
+
+        int16_t *samples = readWavFile(trainingFile->filename, &sampleRate, &numberOfSamples);
+
+        if (samples == NULL || sampleRate != SAMPLE_RATE || numberOfSamples < 2 * BUFFER_SIZE) {
+
+            fprintf(stderr, "Skipping %s, not a 16-bit mono 8kHz WAV file of at least four seconds\n", trainingFile->filename);
+
+            free(samples);
+
+            continue;
+
+        }
+
+        /* Consecutive pairs overlap by a buffer, as in the firmware listening loop */
+
+        trainingFile->numberOfSequences = (numberOfSamples - 2 * BUFFER_SIZE) / BUFFER_SIZE + 1;
+
+        trainingFile->bands = malloc(trainingFile->numberOfSequences * numberOfBands * numberOfFrames * sizeof(float));
+
+        for (uint32_t i = 0; i < trainingFile->numberOfSequences; i += 1) {
+
+            for (uint32_t band = 0; band < numberOfBands; band += 1) {
+
+                values[band] = trainingFile->bands + (i * numberOfBands + band) * numberOfFrames;
+
+            }
+
+            int16_t *pair = samples + i * BUFFER_SIZE;
+
+            extractFeatures(pair, pair + BUFFER_SIZE, values);
+
+        }
+
+        free(samples);
+
+    }
+
+    free(values);
+
+    return NULL;
+
+}
+
+/* Log amplitudes of the model features, frame by frame, for every sequence */
+
+static void collectObservations(void) {
+
+    uint32_t features = model.numberOfFeatures;
+
+    numberOfSequences = 0;
+
+    for (uint32_t i = 0; i < numberOfFiles; i += 1) numberOfSequences += files[i].numberOfSequences;
+
+    observations = malloc((size_t)numberOfSequences * numberOfFrames * features * sizeof(float));
+
+    allowedStates = malloc(numberOfSequences * sizeof(uint32_t));
+
+    float *observation = observations;
+
+    uint32_t *allowed = allowedStates;
+
+    uint32_t allStates = (1u << model.numberOfStates) - 1;
+
+    for (uint32_t i = 0; i < numberOfFiles; i += 1) {
+
+        for (uint32_t j = 0; j < files[i].numberOfSequences; j += 1) {
+
+            *allowed++ = files[i].label == 0 ? allStates & ~(uint32_t)model.detectionStates : allStates;
+
+            float *bands = files[i].bands + j * numberOfBands * numberOfFrames;
+
+            for (uint32_t t = 0; t < numberOfFrames; t += 1) {
+
+                for (uint32_t k = 0; k < features; k += 1) {
+
+                    float amplitude = bands[model.featureIndices[k] * numberOfFrames + t];
+
+                    *observation++ = logf(amplitude > MINIMUM_AMPLITUDE ? amplitude : MINIMUM_AMPLITUDE);
+
+                }
+
+            }
+
+        }
+
+    }
+
+}
+
+/* Emission probabilities scaled by the largest in each frame, with the same floor as the firmware, and zero for states the */
+/* sequence may not occupy. Returns the log of the scale */
+
+static double calculateEmissions(const float *observation, uint32_t allowed, double *emissions) {
+
+    uint32_t states = model.numberOfStates;
+
+    double logEmissions[HMM_MAXIMUM_STATES];
+
+    double maximum = -INFINITY;
+
+    for (uint32_t i = 0; i < states; i += 1) {
+
+        double logEmission = 0.0;
+
+        for (uint32_t k = 0; k < model.numberOfFeatures; k += 1) {
+
+            double difference = observation[k] - model.emissionMean[i][k];
+
+            logEmission += log(model.normalisationFactors[i][k]) - 0.5 * difference * difference * model.oneOverEmissionVariance[i][k];
+
+        }
+
+        logEmissions[i] = logEmission;
+
+        if (logEmission > maximum && (allowed & (1 << i))) maximum = logEmission;
+
+    }
+
+    for (uint32_t i = 0; i < states; i += 1) {
+
+        emissions[i] = exp(logEmissions[i] - maximum);
+
+        if (emissions[i] < model.emissionFloor) emissions[i] = model.emissionFloor;
+
+        if ((allowed & (1 << i)) == 0) emissions[i] = 0.0;
+
+    }
+
+    return maximum;
+
+}
+
+static void accumulateObservation(statistics_t *statistics, const float *observation, uint32_t state, double weight) {
+
+    statistics->occupancy[state] += weight;
+
+    for (uint32_t k = 0; k < model.numberOfFeatures; k += 1) {
+
+        statistics->sum[state][k] += weight * observation[k];
+
+        statistics->sumOfSquares[state][k] += weight * observation[k] * observation[k];
+
+    }
+
+}
+
+/* Scaled forward-backward pass over one sequence */
+
+static void accumulateBaumWelch(statistics_t *statistics, const float *sequence, uint32_t allowed, double *emissions, double *alpha, double *beta, double *scale) {
+
+    uint32_t states = model.numberOfStates;
+
+    uint32_t features = model.numberOfFeatures;
+
+    uint32_t T = numberOfFrames;
+
+    double logLikelihood = 0.0;
+
+    for (uint32_t t = 0; t < T; t += 1) {
+
+        logLikelihood += calculateEmissions(sequence + t * features, allowed, emissions + t * states);
+
+        double *current = alpha + t * states;
+
+        double *b = emissions + t * states;
+
+        double total = 0.0;
+
+        for (uint32_t i = 0; i < states; i += 1) {
+
+            double value = 0.0;
+
+            if (t == 0) {
+
+                value = model.initial[i];
+
+            } else {
+
+                for (uint32_t j = 0; j < states; j += 1) value += alpha[(t - 1) * states + j] * model.transitionMatrix[j][i];
+
+            }
+
+            current[i] = value * b[i];
+
+            total += current[i];
+
+        }
+
+        if (total <= 0.0) total = 1e-300;
+
+        for (uint32_t i = 0; i < states; i += 1) current[i] /= total;
+
+        scale[t] = total;
+
+        logLikelihood += log(total);
+
+    }
+
+    for (uint32_t i = 0; i < states; i += 1) beta[(T - 1) * states + i] = 1.0;
+
+    for (uint32_t t = T - 1; t > 0; t -= 1) {
+
+        double *next = emissions + t * states;
+
+        for (uint32_t i = 0; i < states; i += 1) {
+
+            double value = 0.0;
+
+            for (uint32_t j = 0; j < states; j += 1) value += model.transitionMatrix[i][j] * next[j] * beta[t * states + j];
+
+            beta[(t - 1) * states + i] = value / scale[t];
+
+        }
+
+    }
+
+    /* State occupancies, and transitions weighted by the probability of each pair of consecutive states */
+
+    for (uint32_t t = 0; t < T; t += 1) {
+
+        for (uint32_t i = 0; i < states; i += 1) {
+
+            double gamma = alpha[t * states + i] * beta[t * states + i];
+
+            if (t == 0) statistics->initial[i] += gamma;
+
+            accumulateObservation(statistics, sequence + t * features, i, gamma);
+
+            if (t + 1 < T) {
+
+                statistics->transitionOccupancy[i] += gamma;
+
+                for (uint32_t j = 0; j < states; j += 1) {
+
+                    statistics->transitions[i][j] += alpha[t * states + i] * model.transitionMatrix[i][j] * emissions[(t + 1) * states + j] * beta[(t + 1) * states + j] / scale[t + 1];
+
+                }
+
+            }
+
+        }
+
+    }
+
+    statistics->logLikelihood += logLikelihood;
+
+}
+
+/* Most likely state sequence, counting each frame towards its decoded state only */
+
+static void accumulateViterbi(statistics_t *statistics, const float *sequence, uint32_t allowed, double *emissions, double *score, uint8_t *backPointers) {
+
+    uint32_t states = model.numberOfStates;
+
+    uint32_t features = model.numberOfFeatures;
+
+    uint32_t T = numberOfFrames;
+
+    double logScale = 0.0;
+
+    for (uint32_t t = 0; t < T; t += 1) {
+
+        logScale += calculateEmissions(sequence + t * features, allowed, emissions);
+
+        for (uint32_t i = 0; i < states; i += 1) {
+
+            double best = -INFINITY;
+
+            uint8_t argument = 0;
+
+            if (t == 0) {
+
+                best = log(model.initial[i]);
+
+            } else {
+
+                for (uint32_t j = 0; j < states; j += 1) {
+
+                    double value = score[(t - 1) * states + j] + log(model.transitionMatrix[j][i]);
+
+                    if (value > best) {
+
+                        best = value;
+
+                        argument = j;
+
+                    }
+
+                }
+
+            }
+
+            score[t * states + i] = best + log(emissions[i]);
+
+            backPointers[t * states + i] = argument;
+
+        }
+
+    }
+
+    uint32_t state = 0;
+
+    for (uint32_t i = 1; i < states; i += 1) {
+
+        if (score[(T - 1) * states + i] > score[(T - 1) * states + state]) state = i;
+
+    }
+
+    statistics->logLikelihood += score[(T - 1) * states + state] + logScale;
+
+    for (uint32_t t = T; t > 0; t -= 1) {
+
+        accumulateObservation(statistics, sequence + (t - 1) * features, state, 1.0);
+
+        uint32_t previous = backPointers[(t - 1) * states + state];
+
+        if (t == 1) {
+
+            statistics->initial[state] += 1.0;
+
+        } else {
+
+            statistics->transitions[previous][state] += 1.0;
+
+            statistics->transitionOccupancy[previous] += 1.0;
+
+        }
+
+        state = previous;
+
+    }
+
+}
+
+static void* trainWorker(void *argument) {
+
+    shard_t *shard = argument;
+
+    uint32_t states = model.numberOfStates;
+
+    size_t frameValues = (size_t)numberOfFrames * states;
+
+    double *emissions = malloc(frameValues * sizeof(double));
+
+    double *alpha = malloc(frameValues * sizeof(double));
+
+    double *beta = malloc(frameValues * sizeof(double));
+
+    double *scale = malloc(numberOfFrames * sizeof(double));
+
+    uint8_t *backPointers = malloc(frameValues);
+
+    memset(&shard->statistics, 0, sizeof(statistics_t));
+
+    for (uint32_t i = shard->first; i < shard->last; i += 1) {
+
+        const float *sequence = observations + (size_t)i * numberOfFrames * model.numberOfFeatures;
+
+        if (viterbiTraining) {
+
+            accumulateViterbi(&shard->statistics, sequence, allowedStates[i], emissions, alpha, backPointers);
+
+        } else {
+
+            accumulateBaumWelch(&shard->statistics, sequence, allowedStates[i], emissions, alpha, beta, scale);
+
+        }
+
+    }
+
+    free(emissions);
+    free(alpha);
+    free(beta);
+    free(scale);
+    free(backPointers);
+
+    return NULL;
+
+}
+
+static void addStatistics(statistics_t *total, const statistics_t *statistics) {
+
+    double *to = (double*)total;
+
+    const double *from = (const double*)statistics;
+
+    for (size_t i = 0; i < sizeof(statistics_t) / sizeof(double); i += 1) to[i] += from[i];
+
+}
+
+/* Re-estimate the parameters, leaving those of unvisited states unchanged */
+
+static void updateModel(const statistics_t *statistics) {
+
+    uint32_t states = model.numberOfStates;
+
+    double initialTotal = 0.0;
+
+    for (uint32_t i = 0; i < states; i += 1) initialTotal += statistics->initial[i];
+
+    for (uint32_t i = 0; i < states; i += 1) {
+
+        if (initialTotal > 0.0) model.initial[i] = statistics->initial[i] / initialTotal;
+
+        if (statistics->transitionOccupancy[i] > 0.0) {
+
+            for (uint32_t j = 0; j < states; j += 1) model.transitionMatrix[i][j] = statistics->transitions[i][j] / statistics->transitionOccupancy[i];
+
+        }
+
+        if (statistics->occupancy[i] <= 0.0) continue;
+
+        for (uint32_t k = 0; k < model.numberOfFeatures; k += 1) {
+
+            double mean = statistics->sum[i][k] / statistics->occupancy[i];
+
+            double variance = statistics->sumOfSquares[i][k] / statistics->occupancy[i] - mean * mean;
+
+            if (variance < MINIMUM_VARIANCE) variance = MINIMUM_VARIANCE;
+
+            model.emissionMean[i][k] = mean;
+
+            model.oneOverEmissionVariance[i][k] = 1.0 / variance;
+
+            model.normalisationFactors[i][k] = 1.0 / sqrt(2.0 * M_PI * variance);
+
+        }
+
+    }
+
+}
+
+static double trainIteration(uint32_t numberOfThreads, shard_t *shards, pthread_t *threads) {
+
+    for (uint32_t i = 0; i < numberOfThreads; i += 1) {
+
+        shards[i].first = (uint64_t)numberOfSequences * i / numberOfThreads;
+
+        shards[i].last = (uint64_t)numberOfSequences * (i + 1) / numberOfThreads;
+
+        pthread_create(threads + i, NULL, trainWorker, shards + i);
+
+    }
+
+    statistics_t total;
+
+    memset(&total, 0, sizeof(statistics_t));
+
+    for (uint32_t i = 0; i < numberOfThreads; i += 1) {
+
+        pthread_join(threads[i], NULL);
+
+        addStatistics(&total, &shards[i].statistics);
+
+    }
+
+    updateModel(&total);
+
+    return total.logLikelihood;
+
+}
+
+/* Apply the firmware decoder and decision rule to every pair, reporting detections of labelled recordings */
+
+static void evaluate(const char *title) {
+
+    float **values = malloc(numberOfBands * sizeof(float*));
+
+    uint32_t counts[2][2] = {{0, 0}, {0, 0}};
+
+    for (uint32_t i = 0; i < numberOfFiles; i += 1) {
+
+        if (files[i].label == UNLABELLED || files[i].numberOfSequences == 0) continue;
+
+        bool detectedInFile = false;
+
+        for (uint32_t j = 0; j < files[i].numberOfSequences && !detectedInFile; j += 1) {
+
+            for (uint32_t band = 0; band < numberOfBands; band += 1) {
+
+                values[band] = files[i].bands + (j * numberOfBands + band) * numberOfFrames;
+
+            }
+
+            int16_t detectionFrames = calculate(&model, values, numberOfFrames);
+
+            detectedInFile = detectionFrames >= model.minimumDetectionFrames && detectionFrames <= model.maximumDetectionFrames;
+
+        }
+
+        counts[files[i].label][detectedInFile] += 1;
+
+    }
+
+    free(values);
+
+    uint32_t positives = counts[1][0] + counts[1][1];
+
+    uint32_t negatives = counts[0][0] + counts[0][1];
+
+    printf("%s: detected %u of %u positive recordings", title, counts[1][1], positives);
+
+    if (positives > 0) printf(" (%.1f%%)", 100.0 * counts[1][1] / positives);
+
+    printf(", %u of %u negative recordings", counts[0][1], negatives);
+
+    if (negatives > 0) printf(" (%.1f%%)", 100.0 * counts[0][1] / negatives);
+
+    printf("\n");
+
+}
+
+int main(int argc, char **argv) {
+
+    const char *initialFilename = DEFAULT_INITIAL_MODEL;
+
+    const char *outputFilename = DEFAULT_OUTPUT;
+
+    const char *sourceFilename = NULL;
+
+    uint32_t iterations = DEFAULT_ITERATIONS;
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    uint32_t numberOfThreads = processors > 0 ? processors : 1;
+
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; i += 1) {
+
+        if (strcmp(argv[i], "-v") == 0) {
+
+            viterbiTraining = true;
+
+        } else if (i + 1 < argc && strcmp(argv[i], "-i") == 0) {
+
+            initialFilename = argv[++i];
+
+        } else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+
+            iterations = strtoul(argv[++i], NULL, 10);
+
+        } else if (i + 1 < argc && strcmp(argv[i], "-j") == 0) {
+
+            numberOfThreads = strtoul(argv[++i], NULL, 10);
+
+        } else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+
+            outputFilename = argv[++i];
+
+        } else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+
+            sourceFilename = argv[++i];
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    if (numberOfThreads < 1) numberOfThreads = 1;
+
+    if (numberOfThreads > MAXIMUM_NUMBER_OF_THREADS) numberOfThreads = MAXIMUM_NUMBER_OF_THREADS;
+
+    if (i + 1 != argc || readList(argv[i])) {
+
+        fprintf(stderr, "Usage: %s [-i initial.txt] [-n iterations] [-j threads] [-v] [-o model.txt] [-s model.c] list.txt\n", argv[0]);
+
+        return 1;
+
+    }
+
+    if (readModelText(initialFilename, &model)) {
+
+        fprintf(stderr, "Could not read initial model from %s\n", initialFilename);
+
+        return 1;
+
+    }
+
+    numberOfBands = getNumberOfFeatureBands();
+
+    numberOfFrames = getNumberOfFeatureFrames();
+
+    for (uint32_t k = 0; k < model.numberOfFeatures; k += 1) {
+
+        if (model.featureIndices[k] >= numberOfBands) {
+
+            fprintf(stderr, "Model feature %u uses band %u, but the Goertzel bank has %u bands\n", k, model.featureIndices[k], numberOfBands);
+
+            return 1;
+
+        }
+
+    }
+
+    pthread_t threads[MAXIMUM_NUMBER_OF_THREADS];
+
+    shard_t *shards = malloc(numberOfThreads * sizeof(shard_t));
+
+    /* Extract features in parallel */
+
+    double startTime = getSeconds();
+
+    for (uint32_t j = 0; j < numberOfThreads; j += 1) pthread_create(threads + j, NULL, extractWorker, NULL);
+
+    for (uint32_t j = 0; j < numberOfThreads; j += 1) pthread_join(threads[j], NULL);
+
+    collectObservations();
+
+    if (numberOfSequences == 0) {
+
+        fprintf(stderr, "No usable recordings\n");
+
+        return 1;
+
+    }
+
+    printf("Extracted %u sequences from %u files with %u threads in %.2f seconds\n", numberOfSequences, numberOfFiles, numberOfThreads, getSeconds() - startTime);
+
+    evaluate("Initial model");
+
+    /* Train until the log likelihood per frame stops improving */
+
+    startTime = getSeconds();
+
+    double previousLogLikelihood = -INFINITY;
+
+    for (uint32_t iteration = 0; iteration < iterations; iteration += 1) {
+
+        double logLikelihood = trainIteration(numberOfThreads, shards, threads) / ((double)numberOfSequences * numberOfFrames);
+
+        printf("Iteration %2u: log likelihood per frame %.6f\n", iteration + 1, logLikelihood);
+
+        if (logLikelihood - previousLogLikelihood < CONVERGENCE_THRESHOLD) break;
+
+        previousLogLikelihood = logLikelihood;
+
+    }
+
+    printf("Trained in %.2f seconds\n", getSeconds() - startTime);
+
+    evaluate("Trained model");
+
+    /* Write the description and optionally the source tables */
+
+    FILE *file = fopen(outputFilename, "w");
+
+    if (file == NULL) {
+
+        fprintf(stderr, "Could not write %s\n", outputFilename);
+
+        return 1;
+
+    }
+
+    writeModelText(file, &model);
+
+    fclose(file);
+
+    if (sourceFilename != NULL) {
+
+        file = fopen(sourceFilename, "w");
+
+        if (file == NULL) {
+
+            fprintf(stderr, "Could not write %s\n", sourceFilename);
+
+            return 1;
+
+        }
+
+        writeModelSource(file, &model, "trainedModel");
+
+        fclose(file);
+
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,37 @@
+/****************************************************************************
+ * arm_math.h
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Host replacement for the subset of CMSIS-DSP used by the detector, so
+ * that src/detector.c and src/hmm.c can be compiled by the host tools.
+ *****************************************************************************/
+
+#ifndef ARM_MATH_H_
+#define ARM_MATH_H_
+
+#include <math.h>
+#include <stdint.h>
+
+typedef enum {
+    ARM_MATH_SUCCESS = 0,
+    ARM_MATH_ARGUMENT_ERROR = -1
+} arm_status;
+
+static inline arm_status arm_sqrt_f32(float in, float *pOut) {
+
+    if (in >= 0.0f) {
+
+        *pOut = sqrtf(in);
+
+        return ARM_MATH_SUCCESS;
+
+    }
+
+    *pOut = 0.0f;
+
+    return ARM_MATH_ARGUMENT_ERROR;
+
+}
+
+#endif /* ARM_MATH_H_ */
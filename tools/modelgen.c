@@ -0,0 +1,157 @@
+/****************************************************************************
+ * modelgen.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Builds the MODEL.BIN file read by the firmware from text model
+ * descriptions, and checks existing files. The description format is
+ * given in modeltext.h.
+ *
+ * Build: cc -O2 -I../inc -o modelgen modelgen.c modeltext.c ../src/modelfile.c -lm
+ * Usage: modelgen [-b numberOfBands] -o MODEL.BIN model.txt ...
+ *        modelgen [-b numberOfBands] -c MODEL.BIN
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modelfile.h"
+#include "modeltext.h"
+
+#define DEFAULT_NUMBER_OF_BANDS             3
+
+static modelFile_t modelFile;
+
+static int checkFile(const char *filename, unsigned int numberOfBands) {
+
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL || fread(&modelFile, 1, sizeof(modelFile_t), file) != sizeof(modelFile_t)) {
+
+        fprintf(stderr, "Could not read %u bytes from %s\n", (unsigned int)sizeof(modelFile_t), filename);
+
+        if (file != NULL) fclose(file);
+
+        return 1;
+
+    }
+
+    fclose(file);
+
+    if (!validateModelFile(&modelFile, numberOfBands)) {
+
+        fprintf(stderr, "%s is not a valid version %u model file for %u bands\n", filename, MODEL_FILE_VERSION, numberOfBands);
+
+        return 1;
+
+    }
+
+    for (uint32_t i = 0; i < modelFile.numberOfModels; i += 1) {
+
+        hmmModel_t *model = modelFile.models + i;
+
+        printf("%u: %.*s, %u states, %u features, frames %d to %d\n", (unsigned int)i, HMM_MODEL_NAME_LENGTH, model->name, model->numberOfStates, model->numberOfFeatures, model->minimumDetectionFrames, model->maximumDetectionFrames);
+
+    }
+
+    return 0;
+
+}
+
+int main(int argc, char **argv) {
+
+    unsigned int numberOfBands = DEFAULT_NUMBER_OF_BANDS;
+
+    const char *outputFilename = NULL;
+
+    const char *checkFilename = NULL;
+
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+
+        if (strcmp(argv[i], "-b") == 0) {
+
+            numberOfBands = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-o") == 0) {
+
+            outputFilename = argv[i + 1];
+
+        } else if (strcmp(argv[i], "-c") == 0) {
+
+            checkFilename = argv[i + 1];
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    if (checkFilename != NULL) return checkFile(checkFilename, numberOfBands);
+
+    unsigned int numberOfModels = argc - i;
+
+    if (outputFilename == NULL || numberOfModels == 0 || numberOfModels > MODEL_FILE_MAXIMUM_MODELS) {
+
+        fprintf(stderr, "Usage: %s [-b numberOfBands] -o MODEL.BIN model.txt ... (up to %u models)\n", argv[0], MODEL_FILE_MAXIMUM_MODELS);
+        fprintf(stderr, "       %s [-b numberOfBands] -c MODEL.BIN\n", argv[0]);
+
+        return 1;
+
+    }
+
+    memset(&modelFile, 0, sizeof(modelFile_t));
+
+    for (unsigned int j = 0; j < numberOfModels; j += 1) {
+
+        if (readModelText(argv[i + j], modelFile.models + j)) {
+
+            fprintf(stderr, "Could not read model from %s\n", argv[i + j]);
+
+            return 1;
+
+        }
+
+    }
+
+    modelFile.magic = MODEL_FILE_MAGIC;
+
+    modelFile.version = MODEL_FILE_VERSION;
+
+    modelFile.size = sizeof(modelFile_t);
+
+    modelFile.numberOfModels = numberOfModels;
+
+    modelFile.crc = calculateModelFileCRC(&modelFile);
+
+    if (!validateModelFile(&modelFile, numberOfBands)) {
+
+        fprintf(stderr, "Models do not fit the decoder or use bands beyond %u\n", numberOfBands);
+
+        return 1;
+
+    }
+
+    FILE *file = fopen(outputFilename, "wb");
+
+    if (file == NULL || fwrite(&modelFile, 1, sizeof(modelFile_t), file) != sizeof(modelFile_t)) {
+
+        fprintf(stderr, "Could not write %s\n", outputFilename);
+
+        if (file != NULL) fclose(file);
+
+        return 1;
+
+    }
+
+    fclose(file);
+
+    printf("Wrote %u models to %s, %u bytes, CRC %08X\n", numberOfModels, outputFilename, (unsigned int)sizeof(modelFile_t), (unsigned int)modelFile.crc);
+
+    return 0;
+
+}
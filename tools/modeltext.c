@@ -0,0 +1,334 @@
+/****************************************************************************
+ * modeltext.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modeltext.h"
+
+#define KEYWORD_LENGTH                      32
+
+static int readValues(FILE *file, float *values, unsigned int count) {
+
+    for (unsigned int i = 0; i < count; i += 1) {
+
+        if (fscanf(file, "%f", values + i) != 1) return 1;
+
+    }
+
+    return 0;
+
+}
+
+static int readMatrix(FILE *file, float values[][HMM_MAXIMUM_FEATURES], unsigned int rows, unsigned int columns) {
+
+    for (unsigned int i = 0; i < rows; i += 1) {
+
+        if (readValues(file, values[i], columns)) return 1;
+
+    }
+
+    return 0;
+
+}
+
+static int readIndices(FILE *file, uint8_t *indices, unsigned int *count, unsigned int maximum) {
+
+    if (fscanf(file, "%u", count) != 1 || *count > maximum) return 1;
+
+    for (unsigned int i = 0; i < *count; i += 1) {
+
+        unsigned int index;
+
+        if (fscanf(file, "%u", &index) != 1 || index > UINT8_MAX) return 1;
+
+        indices[i] = index;
+
+    }
+
+    return 0;
+
+}
+
+int readModelText(const char *filename, hmmModel_t *model) {
+
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL) return 1;
+
+    memset(model, 0, sizeof(hmmModel_t));
+
+    float variances[HMM_MAXIMUM_STATES][HMM_MAXIMUM_FEATURES];
+
+    char keyword[KEYWORD_LENGTH];
+
+    unsigned int states = 0, features = 0, count = 0;
+
+    int result = 0;
+
+    while (result == 0 && fscanf(file, "%31s", keyword) == 1) {
+
+        if (strcmp(keyword, "name") == 0) {
+
+            char name[KEYWORD_LENGTH];
+
+            result = fscanf(file, "%31s", name) != 1;
+
+            size_t length = result == 0 ? strlen(name) : 0;
+
+            memcpy(model->name, name, length < HMM_MODEL_NAME_LENGTH ? length : HMM_MODEL_NAME_LENGTH);
+
+        } else if (strcmp(keyword, "states") == 0) {
+
+            result = fscanf(file, "%u", &states) != 1 || states == 0 || states > HMM_MAXIMUM_STATES;
+
+            model->numberOfStates = states;
+
+        } else if (strcmp(keyword, "features") == 0) {
+
+            result = readIndices(file, model->featureIndices, &features, HMM_MAXIMUM_FEATURES);
+
+            model->numberOfFeatures = features;
+
+        } else if (strcmp(keyword, "detectionStates") == 0) {
+
+            uint8_t indices[HMM_MAXIMUM_STATES];
+
+            result = states == 0 || readIndices(file, indices, &count, states);
+
+            for (unsigned int i = 0; result == 0 && i < count; i += 1) {
+
+                result = indices[i] >= states;
+
+                model->detectionStates |= 1 << indices[i];
+
+            }
+
+        } else if (strcmp(keyword, "frames") == 0) {
+
+            int minimum, maximum;
+
+            result = fscanf(file, "%d %d", &minimum, &maximum) != 2;
+
+            model->minimumDetectionFrames = minimum;
+
+            model->maximumDetectionFrames = maximum;
+
+        } else if (strcmp(keyword, "floor") == 0) {
+
+            result = readValues(file, &model->emissionFloor, 1);
+
+        } else if (strcmp(keyword, "initial") == 0) {
+
+            result = states == 0 || readValues(file, model->initial, states);
+
+        } else if (strcmp(keyword, "transitions") == 0) {
+
+            for (unsigned int i = 0; result == 0 && i < states; i += 1) {
+
+                result = readValues(file, model->transitionMatrix[i], states);
+
+            }
+
+            result = result || states == 0;
+
+        } else if (strcmp(keyword, "means") == 0) {
+
+            result = states == 0 || features == 0 || readMatrix(file, model->emissionMean, states, features);
+
+        } else if (strcmp(keyword, "variances") == 0) {
+
+            result = states == 0 || features == 0 || readMatrix(file, variances, states, features);
+
+            /* The decoder uses the reciprocal of each variance and the normal distribution scale */
+
+            for (unsigned int i = 0; result == 0 && i < states; i += 1) {
+
+                for (unsigned int j = 0; result == 0 && j < features; j += 1) {
+
+                    result = variances[i][j] <= 0.0f;
+
+                    model->oneOverEmissionVariance[i][j] = 1.0f / variances[i][j];
+
+                    model->normalisationFactors[i][j] = 1.0 / sqrt(2.0 * M_PI * variances[i][j]);
+
+                }
+
+            }
+
+        } else {
+
+            fprintf(stderr, "Unknown keyword %s in %s\n", keyword, filename);
+
+            result = 1;
+
+        }
+
+    }
+
+    fclose(file);
+
+    return result || states == 0 || features == 0;
+
+}
+
+
+static void writeRows(FILE *file, const float *values, unsigned int rows, unsigned int columns, unsigned int stride) {
+
+    for (unsigned int i = 0; i < rows; i += 1) {
+
+        fprintf(file, "   ");
+
+        for (unsigned int j = 0; j < columns; j += 1) {
+
+            fprintf(file, " %.9g", values[i * stride + j]);
+
+        }
+
+        fprintf(file, "\n");
+
+    }
+
+}
+
+static void writeIndices(FILE *file, const char *keyword, const uint8_t *indices, unsigned int count) {
+
+    fprintf(file, "%s %u", keyword, count);
+
+    for (unsigned int i = 0; i < count; i += 1) fprintf(file, " %u", indices[i]);
+
+    fprintf(file, "\n");
+
+}
+
+void writeModelText(FILE *file, const hmmModel_t *model) {
+
+    unsigned int states = model->numberOfStates;
+
+    unsigned int features = model->numberOfFeatures;
+
+    uint8_t detectionStates[HMM_MAXIMUM_STATES];
+
+    unsigned int count = 0;
+
+    for (unsigned int i = 0; i < states; i += 1) {
+
+        if (model->detectionStates & (1 << i)) detectionStates[count++] = i;
+
+    }
+
+    fprintf(file, "name %.*s\n", HMM_MODEL_NAME_LENGTH, model->name);
+    fprintf(file, "states %u\n", states);
+
+    writeIndices(file, "features", model->featureIndices, features);
+
+    writeIndices(file, "detectionStates", detectionStates, count);
+
+    fprintf(file, "frames %d %d\n", model->minimumDetectionFrames, model->maximumDetectionFrames);
+    fprintf(file, "floor %.9g\n", model->emissionFloor);
+    fprintf(file, "initial\n");
+
+    writeRows(file, model->initial, 1, states, 0);
+
+    fprintf(file, "transitions\n");
+
+    writeRows(file, &model->transitionMatrix[0][0], states, states, HMM_MAXIMUM_STATES);
+
+    fprintf(file, "means\n");
+
+    writeRows(file, &model->emissionMean[0][0], states, features, HMM_MAXIMUM_FEATURES);
+
+    fprintf(file, "variances\n");
+
+    for (unsigned int i = 0; i < states; i += 1) {
+
+        fprintf(file, "   ");
+
+        for (unsigned int j = 0; j < features; j += 1) {
+
+            fprintf(file, " %.9g", 1.0f / model->oneOverEmissionVariance[i][j]);
+
+        }
+
+        fprintf(file, "\n");
+
+    }
+
+}
+
+/* Write a float literal with the same nine significant digits as the text format, adding a decimal point if %g leaves none */
+
+static void writeSourceValue(FILE *file, float value, const char *separator) {
+
+    char literal[32];
+
+    snprintf(literal, sizeof(literal), "%.9g", value);
+
+    fprintf(file, "%s%sf%s", literal, strpbrk(literal, ".e") == NULL ? ".0" : "", separator);
+
+}
+
+static void writeSourceMatrix(FILE *file, const char *field, const float *values, unsigned int rows, unsigned int columns, unsigned int stride, const char *terminator) {
+
+    fprintf(file, "    .%s = {\n", field);
+
+    for (unsigned int i = 0; i < rows; i += 1) {
+
+        fprintf(file, "        {");
+
+        for (unsigned int j = 0; j < columns; j += 1) {
+
+            writeSourceValue(file, values[i * stride + j], j + 1 < columns ? ", " : "");
+
+        }
+
+        fprintf(file, "}%s\n", i + 1 < rows ? "," : "");
+
+    }
+
+    fprintf(file, "    }%s\n", terminator);
+
+}
+
+void writeModelSource(FILE *file, const hmmModel_t *model, const char *variableName) {
+
+    unsigned int states = model->numberOfStates;
+
+    unsigned int features = model->numberOfFeatures;
+
+    fprintf(file, "static const hmmModel_t %s = {\n", variableName);
+    fprintf(file, "    .name = \"%.*s\",\n", HMM_MODEL_NAME_LENGTH - 1, model->name);
+    fprintf(file, "    .numberOfStates = %u,\n", states);
+    fprintf(file, "    .numberOfFeatures = %u,\n", features);
+    fprintf(file, "    .featureIndices = {");
+
+    for (unsigned int j = 0; j < features; j += 1) fprintf(file, "%u%s", model->featureIndices[j], j + 1 < features ? ", " : "");
+
+    fprintf(file, "},\n");
+    fprintf(file, "    .detectionStates = 0x%02X,\n", model->detectionStates);
+    fprintf(file, "    .minimumDetectionFrames = %d,\n", model->minimumDetectionFrames);
+    fprintf(file, "    .maximumDetectionFrames = %d,\n", model->maximumDetectionFrames);
+    fprintf(file, "    .emissionFloor = ");
+    writeSourceValue(file, model->emissionFloor, ",\n");
+
+    writeSourceMatrix(file, "emissionMean", &model->emissionMean[0][0], states, features, HMM_MAXIMUM_FEATURES, ",");
+
+    writeSourceMatrix(file, "oneOverEmissionVariance", &model->oneOverEmissionVariance[0][0], states, features, HMM_MAXIMUM_FEATURES, ",");
+
+    fprintf(file, "    /* ONE_OVER_SQRT_2PI / SQRT_EMISSION_VARIANCE */\n");
+
+    writeSourceMatrix(file, "normalisationFactors", &model->normalisationFactors[0][0], states, features, HMM_MAXIMUM_FEATURES, ",");
+
+    writeSourceMatrix(file, "transitionMatrix", &model->transitionMatrix[0][0], states, states, HMM_MAXIMUM_STATES, ",");
+
+    fprintf(file, "    .initial = {");
+
+    for (unsigned int i = 0; i < states; i += 1) writeSourceValue(file, model->initial[i], i + 1 < states ? ", " : "");
+
+    fprintf(file, "}\n};\n");
+
+}
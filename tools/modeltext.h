@@ -0,0 +1,41 @@
+/****************************************************************************
+ * modeltext.h
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Text description of a detection model, shared by the host tools. Each
+ * description is a list of keywords followed by their values, with states
+ * and features first:
+ *
+ *   name GUNSHOT
+ *   states 4
+ *   features 3 0 1 2          count, then the Goertzel band of each feature
+ *   detectionStates 2 1 2     count, then the states counted as a detection
+ *   frames 1 93               minimum and maximum detection frames
+ *   floor 0.05                emission floor relative to the largest emission
+ *   initial ...               states values
+ *   transitions ...           states x states values, by row
+ *   means ...                 states x features values, by row
+ *   variances ...             states x features values, by row
+ *****************************************************************************/
+
+#ifndef MODELTEXT_H_
+#define MODELTEXT_H_
+
+#include <stdio.h>
+
+#include "hmm.h"
+
+/* Read a description, deriving the reciprocal variances and normalisation factors. Returns non-zero on failure */
+
+int readModelText(const char *filename, hmmModel_t *model);
+
+/* Write a description which readModelText reads back to the same model */
+
+void writeModelText(FILE *file, const hmmModel_t *model);
+
+/* Write the model as a C initialiser in the style of src/models.c */
+
+void writeModelSource(FILE *file, const hmmModel_t *model, const char *variableName);
+
+#endif /* MODELTEXT_H_ */
@@ -0,0 +1,235 @@
+/****************************************************************************
+ * onsetsim.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Host-side simulation of the sound wake mode. Each 8kHz recording is run
+ * through a model of the comparator, which starts the detector a wake
+ * latency after the signal first rises above the threshold, and through
+ * the continuous detector. Recordings found continuously but not after a
+ * wake are onsets lost to the ramp-up.
+ *
+ * Build: cc -O2 -Ihost -I../inc -o onsetsim onsetsim.c wavfile.c ../src/detector.c ../src/hmm.c ../src/models.c ../src/modelfile.c -lm
+ * Usage: onsetsim [-t threshold] [-l latencyMilliseconds] [-d analysisSeconds] [-r rearmSeconds] file.wav ...
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "detector.h"
+#include "wavfile.h"
+
+#define SAMPLE_RATE                         8000
+#define BUFFER_SIZE                         16000
+#define SAMPLE_COUNT                        (2 * BUFFER_SIZE)
+
+/* Defaults match the firmware analysis duration and the power down and initialisation before the comparator is armed again */
+
+#define DEFAULT_THRESHOLD                   2000
+#define DEFAULT_LATENCY                     300
+#define DEFAULT_ANALYSIS_DURATION           10
+#define DEFAULT_REARM_DURATION              6
+
+/* Time constant of the DC level tracked at the comparator input, in samples */
+
+#define DC_TIME_CONSTANT                    4096
+
+static int16_t pair[SAMPLE_COUNT];
+
+/* Run the detector on the pair starting at the given sample, padding past the end of the recording with silence */
+
+static bool detectedAt(int16_t *samples, uint32_t numberOfSamples, uint32_t start) {
+
+    memset(pair, 0, sizeof(pair));
+
+    if (start < numberOfSamples) {
+
+        uint32_t length = numberOfSamples - start < SAMPLE_COUNT ? numberOfSamples - start : SAMPLE_COUNT;
+
+        memcpy(pair, samples + start, length * sizeof(int16_t));
+
+    }
+
+    return detected(pair, pair + BUFFER_SIZE);
+
+}
+
+/* Consecutive pairs overlap by a buffer, as in the firmware listening loop */
+
+static bool detectedContinuously(int16_t *samples, uint32_t numberOfSamples) {
+
+    for (uint32_t start = 0; start == 0 || start + BUFFER_SIZE < numberOfSamples; start += BUFFER_SIZE) {
+
+        if (detectedAt(samples, numberOfSamples, start)) return true;
+
+    }
+
+    return false;
+
+}
+
+/* Returns the first sample at or after start which rises above the threshold relative to the DC level, or numberOfSamples */
+
+static uint32_t findTrigger(int16_t *samples, uint32_t numberOfSamples, uint32_t start, float *dcLevel, int32_t threshold) {
+
+    for (uint32_t i = start; i < numberOfSamples; i += 1) {
+
+        if (samples[i] - *dcLevel > threshold) return i;
+
+        *dcLevel += (samples[i] - *dcLevel) / DC_TIME_CONSTANT;
+
+    }
+
+    return numberOfSamples;
+
+}
+
+int main(int argc, char **argv) {
+
+    int32_t threshold = DEFAULT_THRESHOLD;
+
+    uint32_t latency = DEFAULT_LATENCY;
+
+    uint32_t analysisDuration = DEFAULT_ANALYSIS_DURATION;
+
+    uint32_t rearmDuration = DEFAULT_REARM_DURATION;
+
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+
+        if (strcmp(argv[i], "-t") == 0) {
+
+            threshold = atoi(argv[i + 1]);
+
+        } else if (strcmp(argv[i], "-l") == 0) {
+
+            latency = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-d") == 0) {
+
+            analysisDuration = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-r") == 0) {
+
+            rearmDuration = strtoul(argv[i + 1], NULL, 10);
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    if (i >= argc) {
+
+        fprintf(stderr, "Usage: %s [-t threshold] [-l latencyMilliseconds] [-d analysisSeconds] [-r rearmSeconds] file.wav ...\n", argv[0]);
+
+        return 1;
+
+    }
+
+    uint32_t numberOfFiles = 0;
+
+    uint32_t numberOfWakes = 0;
+
+    uint32_t continuousDetections = 0;
+
+    uint32_t wakeDetections = 0;
+
+    uint32_t missedOnsets = 0;
+
+    printf("file,triggerSeconds,continuous,soundWake\n");
+
+    for (; i < argc; i += 1) {
+
+        uint32_t sampleRate, numberOfSamples;
+
+        int16_t *samples = readWavFile(argv[i], &sampleRate, &numberOfSamples);
+
+        if (samples == NULL || sampleRate != SAMPLE_RATE) {
+
+            fprintf(stderr, "Skipping %s, not a 16-bit mono 8kHz WAV file\n", argv[i]);
+
+            free(samples);
+
+            continue;
+
+        }
+
+        bool continuous = detectedContinuously(samples, numberOfSamples);
+
+        /* Each wake analyses consecutive pairs from the settling point for the analysis duration, then sleeps before arming again */
+
+        bool soundWake = false;
+
+        float dcLevel = samples[0];
+
+        uint32_t firstTrigger = numberOfSamples;
+
+        uint32_t trigger = findTrigger(samples, numberOfSamples, 0, &dcLevel, threshold);
+
+        while (trigger < numberOfSamples && !soundWake) {
+
+            if (firstTrigger == numberOfSamples) firstTrigger = trigger;
+
+            numberOfWakes += 1;
+
+            uint32_t start = trigger + latency * SAMPLE_RATE / 1000;
+
+            uint32_t stop = trigger + analysisDuration * SAMPLE_RATE;
+
+            for (uint32_t pairStart = start; pairStart == start || pairStart + SAMPLE_COUNT <= stop; pairStart += BUFFER_SIZE) {
+
+                if (detectedAt(samples, numberOfSamples, pairStart)) {
+
+                    soundWake = true;
+
+                    break;
+
+                }
+
+            }
+
+            trigger = findTrigger(samples, numberOfSamples, stop + rearmDuration * SAMPLE_RATE, &dcLevel, threshold);
+
+        }
+
+        if (firstTrigger < numberOfSamples) {
+
+            printf("%s,%.3f,%d,%d\n", argv[i], (double)firstTrigger / SAMPLE_RATE, continuous, soundWake);
+
+        } else {
+
+            printf("%s,,%d,%d\n", argv[i], continuous, soundWake);
+
+        }
+
+        numberOfFiles += 1;
+
+        if (continuous) continuousDetections += 1;
+
+        if (soundWake) wakeDetections += 1;
+
+        if (continuous && !soundWake) missedOnsets += 1;
+
+        free(samples);
+
+    }
+
+    printf("\nFiles %u, wakes %u, continuous detections %u, sound wake detections %u, missed onsets %u", numberOfFiles, numberOfWakes, continuousDetections, wakeDetections, missedOnsets);
+
+    if (continuousDetections > 0) {
+
+        printf(" (%.1f%%)", 100.0 * missedOnsets / continuousDetections);
+
+    }
+
+    printf("\n");
+
+    return 0;
+
+}
@@ -0,0 +1,551 @@
+/****************************************************************************
+ * rocsweep.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Sweeps the detection rule of a model over labelled recordings. Every
+ * pair of buffers is decoded once for each emission floor, keeping the
+ * number of frames in the detection states. Each candidate pair of lower
+ * and upper bounds on that number is then scored from those counts without
+ * decoding again, giving the points of an ROC curve and the precision and
+ * recall for each site and for all sites together.
+ *
+ * The list file has one recording per line, followed by 1 if it contains
+ * the target sound or 0 if it does not, and optionally a site name.
+ * Recordings may be 8kHz WAV files or feature caches written by
+ * featurescan. A recording is detected when any of its pairs is.
+ *
+ * Results are written as CSV with one row for each site, floor and pair of
+ * bounds. The best bounds by F1 score for each site and floor are printed
+ * to stderr. With -p the decoded state of every frame is written out too.
+ *
+ * Build: cc -O2 -Ihost -I../inc -o rocsweep rocsweep.c featurecache.c modeltext.c wavfile.c ../src/detector.c ../src/hmm.c ../src/models.c ../src/modelfile.c -lm
+ * Usage: rocsweep [-i model.txt] [-f floor,floor,...] [-g gridStep] [-p paths.txt] list.txt > roc.csv
+ *****************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+
+#include "detector.h"
+#include "featurecache.h"
+#include "modeltext.h"
+#include "wavfile.h"
+
+#define SAMPLE_RATE                         DETECTOR_SAMPLE_RATE
+#define BUFFER_SIZE                         DETECTOR_BUFFER_SIZE
+#define SAMPLE_COUNT                        (2 * BUFFER_SIZE)
+
+#define DEFAULT_INITIAL_MODEL               "models/gunshot.txt"
+#define DEFAULT_FLOORS                      "0.01,0.02,0.05,0.1,0.2"
+
+#define MAXIMUM_NUMBER_OF_FLOORS            32
+#define MAXIMUM_NUMBER_OF_SITES             64
+#define MAXIMUM_SITE_NAME_LENGTH            64
+#define MAXIMUM_LINE_LENGTH                 1024
+
+#define FREQUENCY_TOLERANCE                 0.01f
+
+#define ALL_SITES                           "all"
+
+typedef struct {
+    char *filename;
+    int label;
+    uint32_t site;
+    uint32_t numberOfPairs;
+    int16_t *counts;
+} sweepFile_t;
+
+static sweepFile_t *files;
+
+static uint32_t numberOfFiles;
+
+static char siteNames[MAXIMUM_NUMBER_OF_SITES][MAXIMUM_SITE_NAME_LENGTH];
+
+static uint32_t numberOfSites = 1;
+
+static float floors[MAXIMUM_NUMBER_OF_FLOORS];
+
+static uint32_t numberOfFloors;
+
+static hmmModel_t model;
+
+/* Recordings detected for each label, lower bound and smallest count at or above it */
+
+static uint32_t firstDetections[2][HMM_MAXIMUM_FRAMES + 1][HMM_MAXIMUM_FRAMES + 1];
+
+static double getSeconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+
+}
+
+static bool hasExtension(const char *filename, const char *extension) {
+
+    size_t length = strlen(filename);
+
+    size_t extensionLength = strlen(extension);
+
+    return length >= extensionLength && strcasecmp(filename + length - extensionLength, extension) == 0;
+
+}
+
+static int parseFloors(const char *text) {
+
+    char *end;
+
+    numberOfFloors = 0;
+
+    while (numberOfFloors < MAXIMUM_NUMBER_OF_FLOORS) {
+
+        float value = strtof(text, &end);
+
+        if (end == text || value <= 0.0f || value > 1.0f) return 1;
+
+        floors[numberOfFloors++] = value;
+
+        if (*end != ',') break;
+
+        text = end + 1;
+
+    }
+
+    return *end != '\0';
+
+}
+
+static uint32_t findSite(const char *name) {
+
+    for (uint32_t i = 1; i < numberOfSites; i += 1) {
+
+        if (strcmp(siteNames[i], name) == 0) return i;
+
+    }
+
+    if (numberOfSites == MAXIMUM_NUMBER_OF_SITES) return 0;
+
+    snprintf(siteNames[numberOfSites], MAXIMUM_SITE_NAME_LENGTH, "%s", name);
+
+    return numberOfSites++;
+
+}
+
+static int readList(const char *filename) {
+
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL) return 1;
+
+    char line[MAXIMUM_LINE_LENGTH];
+
+    uint32_t capacity = 0;
+
+    snprintf(siteNames[0], MAXIMUM_SITE_NAME_LENGTH, "%s", ALL_SITES);
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+
+        char path[MAXIMUM_LINE_LENGTH];
+
+        char site[MAXIMUM_SITE_NAME_LENGTH];
+
+        int label;
+
+        int fields = sscanf(line, "%1023s %d %63s", path, &label, site);
+
+        if (fields < 2 || path[0] == '#') continue;
+
+        if (numberOfFiles == capacity) {
+
+            capacity = capacity == 0 ? 256 : 2 * capacity;
+
+            files = realloc(files, capacity * sizeof(sweepFile_t));
+
+        }
+
+        sweepFile_t *sweepFile = files + numberOfFiles;
+
+        memset(sweepFile, 0, sizeof(sweepFile_t));
+
+        sweepFile->filename = strdup(path);
+
+        sweepFile->label = label > 0;
+
+        sweepFile->site = fields == 3 ? findSite(site) : 0;
+
+        numberOfFiles += 1;
+
+    }
+
+    fclose(file);
+
+    return numberOfFiles == 0;
+
+}
+
+/* Load the Goertzel amplitudes of a recording or a feature cache as one column per band, each with room for stride windows */
+
+static float* loadColumns(const char *filename, uint32_t *numberOfWindows, uint32_t *stride) {
+
+    uint32_t numberOfBands = getNumberOfFeatureBands();
+
+    uint32_t numberOfFrames = getNumberOfFeatureFrames();
+
+    uint32_t windowLength = getFeatureWindowLength();
+
+    if (hasExtension(filename, FEATURE_CACHE_EXTENSION)) {
+
+        featureCache_t cache;
+
+        if (openFeatureCache(filename, &cache)) return NULL;
+
+        bool matches = cache.header->sampleRate == SAMPLE_RATE && cache.header->windowLength == windowLength && cache.header->numberOfBands == numberOfBands;
+
+        for (uint32_t band = 0; band < numberOfBands && matches; band += 1) {
+
+            matches = fabsf(cache.header->bandFrequencies[band] - getFeatureBandFrequency(band)) < FREQUENCY_TOLERANCE;
+
+        }
+
+        float *columns = NULL;
+
+        if (matches) {
+
+            *numberOfWindows = *stride = cache.header->numberOfWindows;
+
+            columns = malloc((size_t)numberOfBands * *stride * sizeof(float));
+
+            for (uint32_t band = 0; band < numberOfBands; band += 1) readFeatureCache(&cache, band, 0, *numberOfWindows, columns + band * *stride);
+
+        }
+
+        closeFeatureCache(&cache);
+
+        return columns;
+
+    }
+
+    uint32_t sampleRate, numberOfSamples;
+
+    int16_t *samples = readWavFile(filename, &sampleRate, &numberOfSamples);
+
+    if (samples == NULL || sampleRate != SAMPLE_RATE) {
+
+        free(samples);
+
+        return NULL;
+
+    }
+
+    /* No window straddles a buffer, so consecutive pairs give the windows of every overlapping pair */
+
+    *numberOfWindows = numberOfSamples / windowLength;
+
+    *stride = (*numberOfWindows / numberOfFrames + 1) * numberOfFrames;
+
+    float *columns = malloc((size_t)numberOfBands * *stride * sizeof(float));
+
+    float *values[FEATURE_CACHE_MAXIMUM_BANDS];
+
+    static int16_t pair[SAMPLE_COUNT];
+
+    for (uint32_t start = 0; start < numberOfSamples; start += SAMPLE_COUNT) {
+
+        for (uint32_t band = 0; band < numberOfBands; band += 1) values[band] = columns + band * *stride + start / windowLength;
+
+        if (start + SAMPLE_COUNT <= numberOfSamples) {
+
+            extractFeatures(samples + start, samples + start + BUFFER_SIZE, values);
+
+        } else {
+
+            memset(pair, 0, sizeof(pair));
+
+            memcpy(pair, samples + start, (numberOfSamples - start) * sizeof(int16_t));
+
+            extractFeatures(pair, pair + BUFFER_SIZE, values);
+
+        }
+
+    }
+
+    free(samples);
+
+    return columns;
+
+}
+
+/* Decode every pair of a recording once for each floor, keeping the number of frames in the detection states */
+
+static int decodeFile(sweepFile_t *sweepFile, FILE *pathFile) {
+
+    uint32_t numberOfBands = getNumberOfFeatureBands();
+
+    uint32_t numberOfFrames = getNumberOfFeatureFrames();
+
+    uint32_t windowsPerBuffer = BUFFER_SIZE / getFeatureWindowLength();
+
+    uint32_t numberOfWindows, stride;
+
+    float *columns = loadColumns(sweepFile->filename, &numberOfWindows, &stride);
+
+    if (columns == NULL) {
+
+        fprintf(stderr, "Skipping %s, not an 8kHz WAV file or a feature cache for this Goertzel bank\n", sweepFile->filename);
+
+        return 1;
+
+    }
+
+    if (numberOfWindows < numberOfFrames) {
+
+        fprintf(stderr, "Skipping %s, shorter than a pair of buffers\n", sweepFile->filename);
+
+        free(columns);
+
+        return 1;
+
+    }
+
+    sweepFile->numberOfPairs = (numberOfWindows - numberOfFrames) / windowsPerBuffer + 1;
+
+    sweepFile->counts = malloc((size_t)numberOfFloors * sweepFile->numberOfPairs * sizeof(int16_t));
+
+    float *values[FEATURE_CACHE_MAXIMUM_BANDS];
+
+    hmmModel_t sweepModel = model;
+
+    for (uint32_t i = 0; i < sweepFile->numberOfPairs; i += 1) {
+
+        for (uint32_t band = 0; band < numberOfBands; band += 1) values[band] = columns + band * stride + i * windowsPerBuffer;
+
+        for (uint32_t j = 0; j < numberOfFloors; j += 1) {
+
+            sweepModel.emissionFloor = floors[j];
+
+            sweepFile->counts[j * sweepFile->numberOfPairs + i] = calculate(&sweepModel, values, numberOfFrames);
+
+            if (pathFile == NULL) continue;
+
+            const uint8_t *path = getMostProbableExplanation();
+
+            fprintf(pathFile, "%s %u %g ", sweepFile->filename, i * BUFFER_SIZE / SAMPLE_RATE, floors[j]);
+
+            for (uint32_t t = 0; t < numberOfFrames; t += 1) fputc('0' + path[t], pathFile);
+
+            fputc('\n', pathFile);
+
+        }
+
+    }
+
+    free(columns);
+
+    return 0;
+
+}
+
+/* Score every pair of bounds for one site and floor, returning the best F1 score and its bounds */
+
+static double sweepBounds(uint32_t site, uint32_t floorIndex, uint32_t gridStep, int16_t *bestMinimum, int16_t *bestMaximum) {
+
+    int16_t numberOfFrames = getNumberOfFeatureFrames();
+
+    uint32_t totals[2] = {0, 0};
+
+    memset(firstDetections, 0, sizeof(firstDetections));
+
+    for (uint32_t i = 0; i < numberOfFiles; i += 1) {
+
+        sweepFile_t *sweepFile = files + i;
+
+        if (sweepFile->counts == NULL || (site != 0 && sweepFile->site != site)) continue;
+
+        totals[sweepFile->label] += 1;
+
+        /* Smallest count of any pair at or above each lower bound, so the recording is detected when it is within the upper bound */
+
+        bool present[HMM_MAXIMUM_FRAMES + 2] = {false};
+
+        for (uint32_t j = 0; j < sweepFile->numberOfPairs; j += 1) present[sweepFile->counts[floorIndex * sweepFile->numberOfPairs + j]] = true;
+
+        int16_t next = numberOfFrames + 1;
+
+        for (int16_t minimum = numberOfFrames; minimum >= 1; minimum -= 1) {
+
+            if (present[minimum]) next = minimum;
+
+            if (next <= numberOfFrames) firstDetections[sweepFile->label][minimum][next] += 1;
+
+        }
+
+    }
+
+    double bestScore = -1.0;
+
+    for (int16_t minimum = 1; minimum <= numberOfFrames; minimum += gridStep) {
+
+        uint32_t detections[2] = {0, 0};
+
+        for (int16_t maximum = minimum; maximum <= numberOfFrames; maximum += 1) {
+
+            detections[0] += firstDetections[0][minimum][maximum];
+
+            detections[1] += firstDetections[1][minimum][maximum];
+
+            uint32_t truePositives = detections[1], falsePositives = detections[0];
+
+            uint32_t falseNegatives = totals[1] - truePositives, trueNegatives = totals[0] - falsePositives;
+
+            double recall = totals[1] > 0 ? (double)truePositives / totals[1] : 0.0;
+
+            double precision = truePositives + falsePositives > 0 ? (double)truePositives / (truePositives + falsePositives) : 0.0;
+
+            double falsePositiveRate = totals[0] > 0 ? (double)falsePositives / totals[0] : 0.0;
+
+            double score = precision + recall > 0.0 ? 2.0 * precision * recall / (precision + recall) : 0.0;
+
+            if (score > bestScore) {
+
+                bestScore = score;
+
+                *bestMinimum = minimum;
+
+                *bestMaximum = maximum;
+
+            }
+
+            if ((maximum - minimum) % gridStep != 0 && maximum != numberOfFrames) continue;
+
+            printf("%s,%g,%d,%d,%u,%u,%u,%u,%.4f,%.4f,%.4f\n", siteNames[site], floors[floorIndex], minimum, maximum, truePositives, falseNegatives, falsePositives, trueNegatives, recall, precision, falsePositiveRate);
+
+        }
+
+    }
+
+    return bestScore;
+
+}
+
+int main(int argc, char **argv) {
+
+    const char *modelFilename = DEFAULT_INITIAL_MODEL;
+
+    const char *pathFilename = NULL;
+
+    uint32_t gridStep = 1;
+
+    parseFloors(DEFAULT_FLOORS);
+
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+
+        if (strcmp(argv[i], "-i") == 0) {
+
+            modelFilename = argv[i + 1];
+
+        } else if (strcmp(argv[i], "-f") == 0) {
+
+            if (parseFloors(argv[i + 1])) {
+
+                fprintf(stderr, "Floors must be a comma separated list of values between 0 and 1\n");
+
+                return 1;
+
+            }
+
+        } else if (strcmp(argv[i], "-g") == 0) {
+
+            gridStep = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-p") == 0) {
+
+            pathFilename = argv[i + 1];
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    if (gridStep < 1) gridStep = 1;
+
+    if (i + 1 != argc || readList(argv[i])) {
+
+        fprintf(stderr, "Usage: %s [-i model.txt] [-f floor,floor,...] [-g gridStep] [-p paths.txt] list.txt > roc.csv\n", argv[0]);
+
+        return 1;
+
+    }
+
+    if (readModelText(modelFilename, &model)) {
+
+        fprintf(stderr, "Could not read model from %s\n", modelFilename);
+
+        return 1;
+
+    }
+
+    FILE *pathFile = NULL;
+
+    if (pathFilename != NULL && (pathFile = fopen(pathFilename, "w")) == NULL) {
+
+        fprintf(stderr, "Could not write %s\n", pathFilename);
+
+        return 1;
+
+    }
+
+    /* Decode each pair once for each floor */
+
+    double startTime = getSeconds();
+
+    uint64_t numberOfPairs = 0;
+
+    for (uint32_t j = 0; j < numberOfFiles; j += 1) {
+
+        decodeFile(files + j, pathFile);
+
+        numberOfPairs += files[j].numberOfPairs;
+
+    }
+
+    if (pathFile != NULL) fclose(pathFile);
+
+    fprintf(stderr, "Decoded %llu pairs at %u floors in %.2f seconds\n", (unsigned long long)numberOfPairs, numberOfFloors, getSeconds() - startTime);
+
+    /* Score every pair of bounds for every site and floor from the counts */
+
+    startTime = getSeconds();
+
+    printf("site,floor,minimum,maximum,truePositives,falseNegatives,falsePositives,trueNegatives,recall,precision,falsePositiveRate\n");
+
+    for (uint32_t site = 0; site < numberOfSites; site += 1) {
+
+        for (uint32_t j = 0; j < numberOfFloors; j += 1) {
+
+            int16_t minimum = 0, maximum = 0;
+
+            double score = sweepBounds(site, j, gridStep, &minimum, &maximum);
+
+            fprintf(stderr, "%s floor %g: best F1 %.4f with frames %d to %d\n", siteNames[site], floors[j], score, minimum, maximum);
+
+        }
+
+    }
+
+    fprintf(stderr, "Swept bounds in %.2f seconds\n", getSeconds() - startTime);
+
+    return 0;
+
+}
@@ -0,0 +1,324 @@
+/****************************************************************************
+ * streamdetect.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Runs the firmware detector on a live stream of 16-bit little-endian 8kHz
+ * PCM read from stdin or a FIFO, so a base station or a lab audio
+ * generator can be checked without a device. A reader thread plays the
+ * part of the DMA interrupt, filling the same ring of eight two second
+ * buffers as src/main.c one transfer at a time, while the main thread
+ * analyses each pair of consecutive buffers as the listening loop does.
+ *
+ * Each detection is written to stdout as a JSON line giving the sample at
+ * the start of the first detection frame, its time from the start of the
+ * stream, the first sample of the pair, the models which responded, the
+ * time taken by the detector and the latency from the last sample of the
+ * pair arriving to the end of the analysis. If the ring is full the
+ * reader waits rather than overwriting a buffer, and the waits are
+ * counted as they would have been overruns on a device. A summary
+ * with the sustained real-time factor, the processing time divided by the
+ * duration of audio, is written to stderr at the end of the stream.
+ *
+ * Build: cc -O2 -Ihost -I../inc -o streamdetect streamdetect.c ../src/detector.c ../src/hmm.c ../src/models.c ../src/modelfile.c -lm -lpthread
+ * Usage: streamdetect [-m MODEL.BIN] [-b samplesPerTransfer] [-i input] | ...
+ *****************************************************************************/
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "detector.h"
+#include "models.h"
+
+#define SAMPLE_RATE                         DETECTOR_SAMPLE_RATE
+#define BUFFER_SIZE                         DETECTOR_BUFFER_SIZE
+
+/* Ring and transfer size of src/main.c when capturing at 8kHz */
+
+#define NUMBER_OF_BUFFERS                   8
+#define DEFAULT_SAMPLES_IN_DMA_TRANSFER     128
+#define MAXIMUM_SAMPLES_IN_DMA_TRANSFER     BUFFER_SIZE
+
+#define MILLISECONDS_IN_SECOND              1000.0
+
+static int16_t buffers[NUMBER_OF_BUFFERS][BUFFER_SIZE];
+
+/* Buffers are counted from the start of the stream, and buffer n is held in ring position n % NUMBER_OF_BUFFERS */
+
+static pthread_mutex_t ringMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_cond_t ringCondition = PTHREAD_COND_INITIALIZER;
+
+static uint64_t completedBuffers;
+
+static uint64_t oldestBufferInUse;
+
+static double completionTimes[NUMBER_OF_BUFFERS];
+
+static bool endOfStream;
+
+static uint64_t ringFullWaits;
+
+static FILE *input;
+
+static uint32_t samplesPerDMATransfer = DEFAULT_SAMPLES_IN_DMA_TRANSFER;
+
+static modelFile_t modelFile;
+
+static double getSeconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+
+}
+
+static int loadModelFile(const char *filename) {
+
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL) return 1;
+
+    size_t bytesRead = fread(&modelFile, 1, sizeof(modelFile_t), file);
+
+    fclose(file);
+
+    return bytesRead != sizeof(modelFile_t) || !loadDetectorModels(&modelFile);
+
+}
+
+/* Reader thread, which writes each transfer into the ring and marks the buffer complete when it is full */
+
+static void* readStream(void *argument) {
+
+    (void)argument;
+
+    uint8_t bytes[2 * MAXIMUM_SAMPLES_IN_DMA_TRANSFER];
+
+    uint64_t writeBuffer = 0;
+
+    uint32_t writeBufferIndex = 0;
+
+    while (true) {
+
+        /* Wait before starting a buffer which is still needed by the analysis */
+
+        if (writeBufferIndex == 0) {
+
+            pthread_mutex_lock(&ringMutex);
+
+            if (writeBuffer >= oldestBufferInUse + NUMBER_OF_BUFFERS) ringFullWaits += 1;
+
+            while (writeBuffer >= oldestBufferInUse + NUMBER_OF_BUFFERS) pthread_cond_wait(&ringCondition, &ringMutex);
+
+            pthread_mutex_unlock(&ringMutex);
+
+        }
+
+        if (fread(bytes, 2, samplesPerDMATransfer, input) != samplesPerDMATransfer) break;
+
+        int16_t *samples = buffers[writeBuffer % NUMBER_OF_BUFFERS] + writeBufferIndex;
+
+        for (uint32_t i = 0; i < samplesPerDMATransfer; i += 1) samples[i] = (int16_t)(bytes[2 * i] | bytes[2 * i + 1] << 8);
+
+        writeBufferIndex += samplesPerDMATransfer;
+
+        if (writeBufferIndex == BUFFER_SIZE) {
+
+            pthread_mutex_lock(&ringMutex);
+
+            completionTimes[writeBuffer % NUMBER_OF_BUFFERS] = getSeconds();
+
+            completedBuffers = writeBuffer + 1;
+
+            pthread_cond_broadcast(&ringCondition);
+
+            pthread_mutex_unlock(&ringMutex);
+
+            writeBufferIndex = 0;
+
+            writeBuffer += 1;
+
+        }
+
+    }
+
+    pthread_mutex_lock(&ringMutex);
+
+    endOfStream = true;
+
+    pthread_cond_broadcast(&ringCondition);
+
+    pthread_mutex_unlock(&ringMutex);
+
+    return NULL;
+
+}
+
+static void printEvent(uint64_t onsetSample, uint64_t pairSample, uint32_t detections, double processingTime, double latency) {
+
+    printf("{\"sample\":%llu,\"time\":%.6f,\"pairSample\":%llu,\"models\":[", (unsigned long long)onsetSample, (double)onsetSample / SAMPLE_RATE, (unsigned long long)pairSample);
+
+    bool first = true;
+
+    for (uint32_t i = 0; i < numberOfDetectorModels; i += 1) {
+
+        if ((detections & (1 << i)) == 0) continue;
+
+        printf("%s\"%.*s\"", first ? "" : ",", HMM_MODEL_NAME_LENGTH, detectorModels[i]->name);
+
+        first = false;
+
+    }
+
+    printf("],\"processingMs\":%.3f,\"latencyMs\":%.3f}\n", processingTime * MILLISECONDS_IN_SECOND, latency * MILLISECONDS_IN_SECOND);
+
+    fflush(stdout);
+
+}
+
+int main(int argc, char **argv) {
+
+    const char *inputFilename = NULL;
+
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+
+        if (strcmp(argv[i], "-b") == 0) {
+
+            samplesPerDMATransfer = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-i") == 0) {
+
+            inputFilename = argv[i + 1];
+
+        } else if (strcmp(argv[i], "-m") == 0) {
+
+            if (loadModelFile(argv[i + 1])) {
+
+                fprintf(stderr, "%s is not a valid model file for this Goertzel bank\n", argv[i + 1]);
+
+                return 1;
+
+            }
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    /* The transfer size must divide the buffer, as in the firmware */
+
+    if (i != argc || samplesPerDMATransfer == 0 || samplesPerDMATransfer > MAXIMUM_SAMPLES_IN_DMA_TRANSFER || BUFFER_SIZE % samplesPerDMATransfer != 0) {
+
+        fprintf(stderr, "Usage: %s [-m MODEL.BIN] [-b samplesPerTransfer] [-i input]\n", argv[0]);
+
+        fprintf(stderr, "The transfer size must divide %u samples\n", BUFFER_SIZE);
+
+        return 1;
+
+    }
+
+    input = inputFilename == NULL ? stdin : fopen(inputFilename, "rb");
+
+    if (input == NULL) {
+
+        fprintf(stderr, "Could not open %s\n", inputFilename);
+
+        return 1;
+
+    }
+
+    pthread_t reader;
+
+    pthread_create(&reader, NULL, readStream, NULL);
+
+    double startTime = getSeconds();
+
+    double processingTime = 0.0, totalLatency = 0.0, maximumLatency = 0.0;
+
+    uint64_t numberOfPairs = 0, numberOfEvents = 0;
+
+    /* Pair n is buffers n and n + 1, so consecutive pairs overlap by a buffer as in the listening loop */
+
+    for (uint64_t pair = 0; ; pair += 1) {
+
+        pthread_mutex_lock(&ringMutex);
+
+        while (completedBuffers < pair + 2 && !endOfStream) pthread_cond_wait(&ringCondition, &ringMutex);
+
+        bool available = completedBuffers >= pair + 2;
+
+        double arrivalTime = completionTimes[(pair + 1) % NUMBER_OF_BUFFERS];
+
+        pthread_mutex_unlock(&ringMutex);
+
+        if (!available) break;
+
+        double detectionStartTime = getSeconds();
+
+        uint32_t detections = detected(buffers[pair % NUMBER_OF_BUFFERS], buffers[(pair + 1) % NUMBER_OF_BUFFERS]);
+
+        double detectionEndTime = getSeconds();
+
+        double latency = detectionEndTime - arrivalTime;
+
+        processingTime += detectionEndTime - detectionStartTime;
+
+        totalLatency += latency;
+
+        if (latency > maximumLatency) maximumLatency = latency;
+
+        numberOfPairs += 1;
+
+        if (detections != 0) {
+
+            /* Place the event at the first frame in a detection state, or at the start of the pair if there is none */
+
+            int16_t onsetFrame = getDetectionOnsetFrame();
+
+            uint64_t onsetSample = pair * BUFFER_SIZE + (onsetFrame > 0 ? onsetFrame * getFeatureWindowLength() : 0);
+
+            printEvent(onsetSample, pair * BUFFER_SIZE, detections, detectionEndTime - detectionStartTime, latency);
+
+            numberOfEvents += 1;
+
+        }
+
+        /* Release the first buffer of the pair to the reader */
+
+        pthread_mutex_lock(&ringMutex);
+
+        oldestBufferInUse = pair + 1;
+
+        pthread_cond_broadcast(&ringCondition);
+
+        pthread_mutex_unlock(&ringMutex);
+
+    }
+
+    pthread_join(reader, NULL);
+
+    if (input != stdin) fclose(input);
+
+    double audioDuration = (double)completedBuffers * BUFFER_SIZE / SAMPLE_RATE;
+
+    double wallTime = getSeconds() - startTime;
+
+    fprintf(stderr, "{\"pairs\":%llu,\"events\":%llu,\"audioSeconds\":%.3f,\"wallSeconds\":%.3f,\"processingSeconds\":%.6f,\"realTimeFactor\":%.6f,", (unsigned long long)numberOfPairs, (unsigned long long)numberOfEvents, audioDuration, wallTime, processingTime, audioDuration > 0.0 ? processingTime / audioDuration : 0.0);
+
+    fprintf(stderr, "\"meanLatencyMs\":%.3f,\"maximumLatencyMs\":%.3f,\"ringFullWaits\":%llu}\n", numberOfPairs > 0 ? totalLatency / numberOfPairs * MILLISECONDS_IN_SECOND : 0.0, maximumLatency * MILLISECONDS_IN_SECOND, (unsigned long long)ringFullWaits);
+
+    return 0;
+
+}
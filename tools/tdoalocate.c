@@ -0,0 +1,987 @@
+/****************************************************************************
+ * tdoalocate.c
+ * openacousticdevices.info
+ * October 2026
+ *
+ * Locates shots heard by several devices from the detection recordings in
+ * a fleet's card dumps, laid out as for fleetreplay. Recordings from
+ * different devices close enough in time to have heard the same sound are
+ * grouped, with at most one recording from each device, and each group of
+ * at least three devices is aligned by generalised cross-correlation with
+ * the phase transform (GCC-PHAT) against its earliest recording. The lag
+ * of each correlation peak is limited to what the distance between the
+ * devices and the clock uncertainty allow, and refined to a fraction of a
+ * sample by fitting a parabola. The source position and emission time are
+ * then the least squares fit to the arrival times.
+ *
+ * Recordings are decimated to 8kHz and the spectrum of each is calculated
+ * once per group, two recordings to each complex transform, and the
+ * correlations are inverted two at a time in the same way. Groups are
+ * independent and are shared between threads.
+ *
+ * Detection recordings are named when the pair is analysed, so each is
+ * taken to end at the time in its name. This has a resolution of one
+ * second, so positions are only as good as the clocks allow, and the
+ * residual of each fit is reported so poor groups can be discarded. Where
+ * a recording carries an onset chunk, the millisecond onset time and its
+ * sample give the start instead, good to a tick of the real time clock,
+ * and the lag search between two such recordings narrows to match. The
+ * chunk also gives the offset of recordings trimmed to the detected span.
+ *
+ * Device positions are given as lines of name, latitude and longitude in
+ * degrees. Shots are written to stdout as CSV sorted by time.
+ *
+ * Build: cc -O3 -march=native -Ihost -I../inc -o tdoalocate tdoalocate.c fft.c fleetdir.c wavfile.c ../src/decimator.c -lm -lpthread
+ * Usage: tdoalocate [-j threads] [-n minimumDevices] [-u clockUncertainty] [-c speedOfSound] positions.txt fleetDirectory > shots.csv
+ *****************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "detector.h"
+#include "decimator.h"
+#include "fleetdir.h"
+#include "wavfile.h"
+#include "fft.h"
+
+#define SAMPLE_RATE                         DETECTOR_SAMPLE_RATE
+#define BUFFER_SIZE                         DETECTOR_BUFFER_SIZE
+
+#define DEFAULT_SPEED_OF_SOUND              343.0
+#define DEFAULT_CLOCK_UNCERTAINTY           1.0
+#define DEFAULT_MINIMUM_DEVICES             3
+
+#define MAXIMUM_NUMBER_OF_THREADS           256
+#define MAXIMUM_FFT_ORDER                   24
+
+#define EARTH_RADIUS                        6371000.0
+#define DEGREES_TO_RADIANS                  (M_PI / 180.0)
+
+#define MILLISECONDS_IN_SECOND              1000.0
+
+/* Uncertainty of a start time from an onset chunk, which is latched to a tick of the real time clock */
+
+#define ONSET_TIME_UNCERTAINTY              (1.0 / 256.0)
+
+/* Samples at the detector rate decimated in each block */
+
+#define DECIMATION_BLOCK_SIZE               128
+
+/* Neighbouring devices can detect the same shot in consecutive pairs, which start a buffer apart */
+
+#define PAIR_STEP_DURATION                  ((double)BUFFER_SIZE / SAMPLE_RATE)
+
+/* Small value added to the magnitude of each cross-spectrum bin before whitening */
+
+#define PHAT_EPSILON                        1e-9f
+
+/* Position fit */
+
+#define FIT_ITERATIONS                      50
+#define FIT_DAMPING                         1e-3
+#define FIT_TOLERANCE                       1e-6
+
+typedef struct {
+    uint32_t device;
+    uint32_t recording;
+} member_t;
+
+typedef struct {
+    uint32_t firstMember;
+    uint32_t numberOfMembers;
+    bool located;
+    double emissionTime;
+    double x;
+    double y;
+    double residual;
+    double coherence;
+} group_t;
+
+static const char *fleetDirectory;
+
+static fleetDevice_t *devices;
+
+static uint32_t numberOfDevices;
+
+/* Device positions in metres east and north of the centre of the fleet */
+
+static bool *hasPosition;
+
+static double *positionX, *positionY;
+
+static double centreLatitude, centreLongitude;
+
+static member_t *members;
+
+static uint32_t numberOfMembers;
+
+static group_t *groups;
+
+static uint32_t numberOfGroups;
+
+static double speedOfSound = DEFAULT_SPEED_OF_SOUND;
+
+static double clockUncertainty = DEFAULT_CLOCK_UNCERTAINTY;
+
+/* Work distribution and the plans for each transform length */
+
+static pthread_mutex_t groupMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t nextGroup;
+
+static pthread_mutex_t planMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static fftPlan_t *plans[MAXIMUM_FFT_ORDER + 1];
+
+static double getSeconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+
+}
+
+static int32_t findDevice(const char *name) {
+
+    for (uint32_t i = 0; i < numberOfDevices; i += 1) {
+
+        if (strcmp(devices[i].name, name) == 0) return i;
+
+    }
+
+    return -1;
+
+}
+
+static int readPositions(const char *filename) {
+
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL) return 1;
+
+    hasPosition = calloc(numberOfDevices, sizeof(bool));
+
+    positionX = calloc(numberOfDevices, sizeof(double));
+
+    positionY = calloc(numberOfDevices, sizeof(double));
+
+    double *latitudes = calloc(numberOfDevices, sizeof(double));
+
+    double *longitudes = calloc(numberOfDevices, sizeof(double));
+
+    char line[FLEET_MAXIMUM_PATH_LENGTH];
+
+    uint32_t numberOfPositions = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+
+        char name[FLEET_MAXIMUM_NAME_LENGTH];
+
+        double latitude, longitude;
+
+        if (line[0] == '#' || sscanf(line, "%255s %lf %lf", name, &latitude, &longitude) != 3) continue;
+
+        int32_t device = findDevice(name);
+
+        if (device < 0) continue;
+
+        hasPosition[device] = true;
+
+        latitudes[device] = latitude;
+
+        longitudes[device] = longitude;
+
+        centreLatitude += latitude;
+
+        centreLongitude += longitude;
+
+        numberOfPositions += 1;
+
+    }
+
+    fclose(file);
+
+    /* Project onto a plane tangent at the centre, which is accurate to well within a metre over a few kilometres */
+
+    if (numberOfPositions > 0) {
+
+        centreLatitude /= numberOfPositions;
+
+        centreLongitude /= numberOfPositions;
+
+    }
+
+    for (uint32_t i = 0; i < numberOfDevices; i += 1) {
+
+        if (!hasPosition[i]) {
+
+            if (devices[i].numberOfRecordings > 0) fprintf(stderr, "Ignoring %s, which has no position\n", devices[i].name);
+
+            continue;
+
+        }
+
+        positionX[i] = EARTH_RADIUS * (longitudes[i] - centreLongitude) * DEGREES_TO_RADIANS * cos(centreLatitude * DEGREES_TO_RADIANS);
+
+        positionY[i] = EARTH_RADIUS * (latitudes[i] - centreLatitude) * DEGREES_TO_RADIANS;
+
+    }
+
+    free(latitudes);
+
+    free(longitudes);
+
+    return 0;
+
+}
+
+static double getDistance(uint32_t a, uint32_t b) {
+
+    return hypot(positionX[a] - positionX[b], positionY[a] - positionY[b]);
+
+}
+
+/* Grouping */
+
+static int compareMembers(const void *a, const void *b) {
+
+    const member_t *first = a, *second = b;
+
+    uint32_t firstTime = devices[first->device].recordings[first->recording].nameTime;
+
+    uint32_t secondTime = devices[second->device].recordings[second->recording].nameTime;
+
+    if (firstTime != secondTime) return firstTime < secondTime ? -1 : 1;
+
+    return first->device < second->device ? -1 : first->device > second->device;
+
+}
+
+/* Starting from the earliest recording not yet grouped, add the closest recording from each other device within the window */
+
+static void formGroups(uint32_t minimumDevices) {
+
+    member_t *all = NULL;
+
+    uint32_t numberOfRecordings = 0;
+
+    double largestDistance = 0.0;
+
+    for (uint32_t i = 0; i < numberOfDevices; i += 1) {
+
+        if (!hasPosition[i]) continue;
+
+        for (uint32_t j = 0; j < numberOfDevices; j += 1) {
+
+            if (hasPosition[j] && getDistance(i, j) > largestDistance) largestDistance = getDistance(i, j);
+
+        }
+
+        all = realloc(all, (numberOfRecordings + devices[i].numberOfRecordings) * sizeof(member_t));
+
+        for (uint32_t j = 0; j < devices[i].numberOfRecordings; j += 1) all[numberOfRecordings++] = (member_t){.device = i, .recording = j};
+
+    }
+
+    qsort(all, numberOfRecordings, sizeof(member_t), compareMembers);
+
+    double window = largestDistance / speedOfSound + PAIR_STEP_DURATION + clockUncertainty;
+
+    bool *grouped = calloc(numberOfRecordings, sizeof(bool));
+
+    bool *deviceInGroup = calloc(numberOfDevices, sizeof(bool));
+
+    members = malloc(numberOfRecordings * sizeof(member_t));
+
+    for (uint32_t i = 0; i < numberOfRecordings; i += 1) {
+
+        if (grouped[i]) continue;
+
+        uint32_t firstTime = devices[all[i].device].recordings[all[i].recording].nameTime;
+
+        uint32_t groupSize = 0;
+
+        memset(deviceInGroup, 0, numberOfDevices * sizeof(bool));
+
+        for (uint32_t j = i; j < numberOfRecordings; j += 1) {
+
+            uint32_t time = devices[all[j].device].recordings[all[j].recording].nameTime;
+
+            if (time > firstTime + window) break;
+
+            if (grouped[j] || deviceInGroup[all[j].device]) continue;
+
+            deviceInGroup[all[j].device] = true;
+
+            members[numberOfMembers + groupSize++] = all[j];
+
+        }
+
+        /* Only the first recording is used up by a group too small to locate, so the others can start or join later groups */
+
+        grouped[i] = true;
+
+        if (groupSize < minimumDevices) continue;
+
+        for (uint32_t j = i + 1, k = 1; j < numberOfRecordings && k < groupSize; j += 1) {
+
+            if (all[j].device == members[numberOfMembers + k].device && all[j].recording == members[numberOfMembers + k].recording) {
+
+                grouped[j] = true;
+
+                k += 1;
+
+            }
+
+        }
+
+        groups = realloc(groups, (numberOfGroups + 1) * sizeof(group_t));
+
+        groups[numberOfGroups++] = (group_t){.firstMember = numberOfMembers, .numberOfMembers = groupSize};
+
+        numberOfMembers += groupSize;
+
+    }
+
+    free(deviceInGroup);
+
+    free(grouped);
+
+    free(all);
+
+}
+
+/* Signal processing */
+
+static const fftPlan_t* getPlan(uint32_t order) {
+
+    pthread_mutex_lock(&planMutex);
+
+    if (plans[order] == NULL) plans[order] = createFFTPlan(1u << order);
+
+    pthread_mutex_unlock(&planMutex);
+
+    return plans[order];
+
+}
+
+/* Read a recording, decimate it to 8kHz and remove its mean. The filter delay is returned as the time of the first output sample relative to the first input sample. Returns NULL on failure */
+
+static float* readRecording(const member_t *member, uint32_t *numberOfSamples, double *startTime, double *uncertainty) {
+
+    char path[FLEET_MAXIMUM_PATH_LENGTH];
+
+    getFleetRecordingPath(fleetDirectory, devices + member->device, devices[member->device].recordings + member->recording, path, sizeof(path));
+
+    uint32_t sampleRate, numberOfInputSamples;
+
+    int16_t *samples = readWavFile(path, &sampleRate, &numberOfInputSamples);
+
+    uint32_t factor = sampleRate / SAMPLE_RATE;
+
+    if (samples == NULL || sampleRate % SAMPLE_RATE != 0 || factor < 1 || factor > DECIMATOR_MAXIMUM_FACTOR) {
+
+        fprintf(stderr, "Skipping %s, not a 16-bit mono WAV file at a multiple of 8kHz\n", path);
+
+        free(samples);
+
+        return NULL;
+
+    }
+
+    uint32_t blockSize = DECIMATION_BLOCK_SIZE * factor;
+
+    uint32_t numberOfBlocks = numberOfInputSamples / blockSize;
+
+    float *signal = malloc((numberOfBlocks * DECIMATION_BLOCK_SIZE + 1) * sizeof(float));
+
+    decimator_t decimator;
+
+    initialiseDecimator(&decimator, factor, blockSize);
+
+    int16_t decimated[DECIMATION_BLOCK_SIZE];
+
+    double mean = 0.0;
+
+    for (uint32_t block = 0; block < numberOfBlocks; block += 1) {
+
+        int16_t *input = samples + block * blockSize;
+
+        if (factor > 1) {
+
+            decimate(&decimator, input, decimated, blockSize);
+
+            input = decimated;
+
+        }
+
+        for (uint32_t i = 0; i < DECIMATION_BLOCK_SIZE; i += 1) {
+
+            signal[block * DECIMATION_BLOCK_SIZE + i] = input[i];
+
+            mean += input[i];
+
+        }
+
+    }
+
+    free(samples);
+
+    *numberOfSamples = numberOfBlocks * DECIMATION_BLOCK_SIZE;
+
+    /* Output sample i is centred on input sample i * factor less half the filter length */
+
+    double delay = factor > 1 ? (1.0 - DECIMATOR_TAPS_PER_PHASE * factor) / 2.0 / sampleRate : 0.0;
+
+    /* Detection recordings end at the time in their name, unless the onset chunk times them more closely */
+
+    *uncertainty = getFleetRecordingStartTime(path, devices[member->device].recordings + member->recording, sampleRate, numberOfInputSamples, true, startTime) ? ONSET_TIME_UNCERTAINTY : clockUncertainty;
+
+    *startTime += delay;
+
+    if (*numberOfSamples > 0) mean /= *numberOfSamples;
+
+    for (uint32_t i = 0; i < *numberOfSamples; i += 1) signal[i] -= mean;
+
+    return signal;
+
+}
+
+/* Whitened cross-spectrum of a reference and another recording, which correlates to a peak at the lag of the reference */
+
+static void getPhaseTransform(const fftComplex_t *reference, const fftComplex_t *other, fftComplex_t *cross, uint32_t numberOfBins) {
+
+    for (uint32_t k = 0; k < numberOfBins; k += 1) {
+
+        float real = reference[k].real * other[k].real + reference[k].imaginary * other[k].imaginary;
+
+        float imaginary = reference[k].imaginary * other[k].real - reference[k].real * other[k].imaginary;
+
+        float magnitude = sqrtf(real * real + imaginary * imaginary) + PHAT_EPSILON;
+
+        cross[k].real = real / magnitude;
+
+        cross[k].imaginary = imaginary / magnitude;
+
+    }
+
+}
+
+/* Find the largest correlation between the lags, refined by a parabola through the peak and its neighbours */
+
+static double findPeak(const float *correlation, uint32_t length, int32_t minimumLag, int32_t maximumLag, double *height) {
+
+    int32_t best = minimumLag;
+
+    float bestValue = -FLT_MAX;
+
+    for (int32_t lag = minimumLag; lag <= maximumLag; lag += 1) {
+
+        float value = correlation[(uint32_t)lag & (length - 1)];
+
+        if (value > bestValue) {
+
+            bestValue = value;
+
+            best = lag;
+
+        }
+
+    }
+
+    float before = correlation[(uint32_t)(best - 1) & (length - 1)];
+
+    float after = correlation[(uint32_t)(best + 1) & (length - 1)];
+
+    float curvature = before - 2.0f * bestValue + after;
+
+    double offset = curvature < 0.0f ? 0.5 * (before - after) / curvature : 0.0;
+
+    *height = bestValue / length;
+
+    return best + offset;
+
+}
+
+/* Sum of squared residuals in metres, and its normal equations, for a position and emission offset */
+
+static double getFitCost(const uint32_t *groupDevices, const double *arrivals, uint32_t count, const double parameters[3], double normal[3][3], double gradient[3]) {
+
+    double cost = 0.0;
+
+    memset(normal, 0, 9 * sizeof(double));
+
+    memset(gradient, 0, 3 * sizeof(double));
+
+    for (uint32_t i = 0; i < count; i += 1) {
+
+        double dx = parameters[0] - positionX[groupDevices[i]];
+
+        double dy = parameters[1] - positionY[groupDevices[i]];
+
+        double distance = hypot(dx, dy) + FIT_TOLERANCE;
+
+        double residual = arrivals[i] * speedOfSound - parameters[2] - distance;
+
+        double jacobian[3] = {dx / distance, dy / distance, 1.0};
+
+        cost += residual * residual;
+
+        for (uint32_t j = 0; j < 3; j += 1) {
+
+            gradient[j] += jacobian[j] * residual;
+
+            for (uint32_t k = 0; k < 3; k += 1) normal[j][k] += jacobian[j] * jacobian[k];
+
+        }
+
+    }
+
+    return cost;
+
+}
+
+static double getDeterminant(double matrix[3][3]) {
+
+    return matrix[0][0] * (matrix[1][1] * matrix[2][2] - matrix[1][2] * matrix[2][1]) - matrix[0][1] * (matrix[1][0] * matrix[2][2] - matrix[1][2] * matrix[2][0]) + matrix[0][2] * (matrix[1][0] * matrix[2][1] - matrix[1][1] * matrix[2][0]);
+
+}
+
+/* Fit the position and emission time to the arrival times with lightly damped Gauss-Newton steps from the given position. Returns the RMS residual in seconds */
+
+static double fitPosition(const uint32_t *groupDevices, const double *arrivals, uint32_t count, double *x, double *y, double *emission) {
+
+    double parameters[3] = {*x, *y, 0.0};
+
+    /* Start from the emission offset which best fits the starting position */
+
+    for (uint32_t i = 0; i < count; i += 1) parameters[2] += (arrivals[i] * speedOfSound - hypot(parameters[0] - positionX[groupDevices[i]], parameters[1] - positionY[groupDevices[i]])) / count;
+
+    double normal[3][3], gradient[3];
+
+    double cost = getFitCost(groupDevices, arrivals, count, parameters, normal, gradient);
+
+    for (uint32_t iteration = 0; iteration < FIT_ITERATIONS; iteration += 1) {
+
+        for (uint32_t j = 0; j < 3; j += 1) normal[j][j] *= 1.0 + FIT_DAMPING;
+
+        /* Solve the three by three system by Cramer's rule */
+
+        double determinant = getDeterminant(normal);
+
+        if (fabs(determinant) < DBL_MIN) break;
+
+        double step[3];
+
+        for (uint32_t j = 0; j < 3; j += 1) {
+
+            double matrix[3][3];
+
+            memcpy(matrix, normal, sizeof(matrix));
+
+            for (uint32_t k = 0; k < 3; k += 1) matrix[k][j] = gradient[k];
+
+            step[j] = getDeterminant(matrix) / determinant;
+
+        }
+
+        for (uint32_t j = 0; j < 3; j += 1) parameters[j] += step[j];
+
+        cost = getFitCost(groupDevices, arrivals, count, parameters, normal, gradient);
+
+        if (fabs(step[0]) + fabs(step[1]) < FIT_TOLERANCE) break;
+
+    }
+
+    *x = parameters[0];
+
+    *y = parameters[1];
+
+    *emission = parameters[2] / speedOfSound;
+
+    return sqrt(cost / count) / speedOfSound;
+
+}
+
+/* Align the recordings of a group and fit the source, given at least three recordings */
+
+static void alignAndFit(group_t *group, float **signals, const uint32_t *lengths, const double *startTimes, const double *uncertainties, const uint32_t *groupDevices, uint32_t used) {
+
+    uint32_t longest = 0;
+
+    for (uint32_t i = 0; i < used; i += 1) {
+
+        if (lengths[i] > longest) longest = lengths[i];
+
+    }
+
+    /* Zero pad to twice the longest recording so the correlations do not wrap */
+
+    uint32_t order = 1;
+
+    while ((1u << order) < 2 * longest) order += 1;
+
+    if (order > MAXIMUM_FFT_ORDER) return;
+
+    double *arrivals = calloc(used, sizeof(double));
+
+    const fftPlan_t *plan = getPlan(order);
+
+    uint32_t length = plan->length, numberOfBins = length / 2 + 1;
+
+    fftComplex_t *spectra = malloc((size_t)(used + 1) * numberOfBins * sizeof(fftComplex_t));
+
+    fftComplex_t *cross = malloc(2 * numberOfBins * sizeof(fftComplex_t));
+
+    fftComplex_t *scratch = malloc(length * sizeof(fftComplex_t));
+
+    float *correlations = malloc(2 * length * sizeof(float));
+
+    /* Spectrum of each recording, two to a transform */
+
+    for (uint32_t i = 0; i < used; i += 2) {
+
+        uint32_t next = i + 1 < used ? i + 1 : i;
+
+        transformTwoRealFFT(plan, signals[i], lengths[i], signals[next], i + 1 < used ? lengths[next] : 0, spectra + (size_t)i * numberOfBins, spectra + (size_t)(i + 1) * numberOfBins, scratch);
+
+    }
+
+    /* Correlate each recording against the first, two to an inverse transform, and convert the lags to arrival times */
+
+    double coherence = 0.0;
+
+    arrivals[0] = 0.0;
+
+    for (uint32_t i = 1; i < used; i += 2) {
+
+        uint32_t numberOfPairs = i + 1 < used ? 2 : 1;
+
+        for (uint32_t j = 0; j < numberOfPairs; j += 1) getPhaseTransform(spectra, spectra + (size_t)(i + j) * numberOfBins, cross + j * numberOfBins, numberOfBins);
+
+        if (numberOfPairs == 1) memset(cross + numberOfBins, 0, numberOfBins * sizeof(fftComplex_t));
+
+        inverseTwoRealFFT(plan, cross, cross + numberOfBins, correlations, correlations + length, scratch);
+
+        for (uint32_t j = 0; j < numberOfPairs; j += 1) {
+
+            uint32_t m = i + j;
+
+            double offset = startTimes[m] - startTimes[0];
+
+            double allowed = getDistance(groupDevices[0], groupDevices[m]) / speedOfSound + fmin(clockUncertainty, uncertainties[0] + uncertainties[m]);
+
+            int32_t minimumLag = (int32_t)floor((offset - allowed) * SAMPLE_RATE);
+
+            int32_t maximumLag = (int32_t)ceil((offset + allowed) * SAMPLE_RATE);
+
+            int32_t limit = (int32_t)length / 2 - 1;
+
+            if (minimumLag < -limit) minimumLag = -limit;
+
+            if (maximumLag > limit) maximumLag = limit;
+
+            double height;
+
+            double lag = findPeak(correlations + j * length, length, minimumLag, maximumLag, &height);
+
+            arrivals[m] = offset - lag / SAMPLE_RATE;
+
+            coherence += height;
+
+        }
+
+    }
+
+    /* Fit from the centre of the group and from a metre away from each device, where the distance is not zero, keeping the best */
+
+    double bestResidual = DBL_MAX;
+
+    for (uint32_t i = 0; i <= used; i += 1) {
+
+        double x = 0.0, y = 0.0, emission;
+
+        if (i == used) {
+
+            for (uint32_t j = 0; j < used; j += 1) {
+
+                x += positionX[groupDevices[j]] / used;
+
+                y += positionY[groupDevices[j]] / used;
+
+            }
+
+        } else {
+
+            x = positionX[groupDevices[i]] + 1.0;
+
+            y = positionY[groupDevices[i]] + 1.0;
+
+        }
+
+        double residual = fitPosition(groupDevices, arrivals, used, &x, &y, &emission);
+
+        if (residual < bestResidual) {
+
+            bestResidual = residual;
+
+            group->x = x;
+
+            group->y = y;
+
+            group->emissionTime = emission;
+
+        }
+
+    }
+
+    /* The emission time is relative to the arrival at the first device, which is placed at the largest sample of its recording */
+
+    uint32_t loudest = 0;
+
+    for (uint32_t i = 1; i < lengths[0]; i += 1) {
+
+        if (fabsf(signals[0][i]) > fabsf(signals[0][loudest])) loudest = i;
+
+    }
+
+    group->emissionTime += startTimes[0] + (double)loudest / SAMPLE_RATE;
+
+    group->residual = bestResidual;
+
+    group->coherence = coherence / (used - 1);
+
+    group->located = true;
+
+    free(correlations);
+
+    free(scratch);
+
+    free(cross);
+
+    free(spectra);
+
+    free(arrivals);
+
+}
+
+static void locateGroup(group_t *group) {
+
+    uint32_t count = group->numberOfMembers;
+
+    member_t *groupMembers = members + group->firstMember;
+
+    float **signals = calloc(count, sizeof(float*));
+
+    uint32_t *lengths = calloc(count, sizeof(uint32_t));
+
+    double *startTimes = calloc(count, sizeof(double));
+
+    double *uncertainties = calloc(count, sizeof(double));
+
+    uint32_t *groupDevices = calloc(count, sizeof(uint32_t));
+
+    /* Read the recordings, dropping any which cannot be used */
+
+    uint32_t used = 0;
+
+    for (uint32_t i = 0; i < count; i += 1) {
+
+        signals[used] = readRecording(groupMembers + i, lengths + used, startTimes + used, uncertainties + used);
+
+        if (signals[used] == NULL || lengths[used] == 0) {
+
+            free(signals[used]);
+
+            continue;
+
+        }
+
+        groupDevices[used] = groupMembers[i].device;
+
+        used += 1;
+
+    }
+
+    if (used >= 3) alignAndFit(group, signals, lengths, startTimes, uncertainties, groupDevices, used);
+
+    for (uint32_t i = 0; i < used; i += 1) free(signals[i]);
+
+    free(signals);
+
+    free(lengths);
+
+    free(startTimes);
+
+    free(uncertainties);
+
+    free(groupDevices);
+
+}
+
+static void* locateWorker(void *argument) {
+
+    (void)argument;
+
+    while (true) {
+
+        pthread_mutex_lock(&groupMutex);
+
+        uint32_t index = nextGroup++;
+
+        pthread_mutex_unlock(&groupMutex);
+
+        if (index >= numberOfGroups) break;
+
+        locateGroup(groups + index);
+
+    }
+
+    return NULL;
+
+}
+
+static int compareGroups(const void *a, const void *b) {
+
+    const group_t *first = a, *second = b;
+
+    return first->emissionTime < second->emissionTime ? -1 : first->emissionTime > second->emissionTime;
+
+}
+
+static void writeShots(void) {
+
+    qsort(groups, numberOfGroups, sizeof(group_t), compareGroups);
+
+    printf("time,latitude,longitude,residualMs,coherence,devices\n");
+
+    for (uint32_t i = 0; i < numberOfGroups; i += 1) {
+
+        group_t *group = groups + i;
+
+        if (!group->located) continue;
+
+        /* Round to the millisecond before splitting off the seconds, so a time just before a minute does not print as 60 seconds */
+
+        double milliseconds = round(group->emissionTime * MILLISECONDS_IN_SECOND);
+
+        time_t seconds = (time_t)floor(milliseconds / MILLISECONDS_IN_SECOND);
+
+        struct tm time;
+
+        gmtime_r(&seconds, &time);
+
+        double latitude = centreLatitude + group->y / EARTH_RADIUS / DEGREES_TO_RADIANS;
+
+        double longitude = centreLongitude + group->x / (EARTH_RADIUS * cos(centreLatitude * DEGREES_TO_RADIANS)) / DEGREES_TO_RADIANS;
+
+        printf("%04d-%02d-%02dT%02d:%02d:%06.3fZ,%.6f,%.6f,%.3f,%.3f,", 1900 + time.tm_year, 1 + time.tm_mon, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec + (milliseconds - seconds * MILLISECONDS_IN_SECOND) / MILLISECONDS_IN_SECOND, latitude, longitude, group->residual * MILLISECONDS_IN_SECOND, group->coherence);
+
+        for (uint32_t j = 0; j < group->numberOfMembers; j += 1) printf("%s%s", j == 0 ? "" : " ", devices[members[group->firstMember + j].device].name);
+
+        printf("\n");
+
+    }
+
+}
+
+int main(int argc, char **argv) {
+
+    uint32_t minimumDevices = DEFAULT_MINIMUM_DEVICES;
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    uint32_t numberOfThreads = processors > 0 ? processors : 1;
+
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+
+        if (strcmp(argv[i], "-j") == 0) {
+
+            numberOfThreads = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-n") == 0) {
+
+            minimumDevices = strtoul(argv[i + 1], NULL, 10);
+
+        } else if (strcmp(argv[i], "-u") == 0) {
+
+            clockUncertainty = strtod(argv[i + 1], NULL);
+
+        } else if (strcmp(argv[i], "-c") == 0) {
+
+            speedOfSound = strtod(argv[i + 1], NULL);
+
+        } else {
+
+            break;
+
+        }
+
+    }
+
+    if (numberOfThreads < 1) numberOfThreads = 1;
+
+    if (numberOfThreads > MAXIMUM_NUMBER_OF_THREADS) numberOfThreads = MAXIMUM_NUMBER_OF_THREADS;
+
+    if (minimumDevices < 3) minimumDevices = 3;
+
+    if (i + 2 != argc || clockUncertainty < 0.0 || speedOfSound <= 0.0) {
+
+        fprintf(stderr, "Usage: %s [-j threads] [-n minimumDevices] [-u clockUncertainty] [-c speedOfSound] positions.txt fleetDirectory\n", argv[0]);
+
+        return 1;
+
+    }
+
+    fleetDirectory = argv[i + 1];
+
+    if (!readFleetDirectory(fleetDirectory, &devices, &numberOfDevices)) {
+
+        fprintf(stderr, "Could not read %s\n", fleetDirectory);
+
+        return 1;
+
+    }
+
+    if (readPositions(argv[i])) {
+
+        fprintf(stderr, "Could not read %s\n", argv[i]);
+
+        return 1;
+
+    }
+
+    formGroups(minimumDevices);
+
+    double startTime = getSeconds();
+
+    pthread_t threads[MAXIMUM_NUMBER_OF_THREADS];
+
+    for (uint32_t j = 0; j < numberOfThreads; j += 1) pthread_create(threads + j, NULL, locateWorker, NULL);
+
+    for (uint32_t j = 0; j < numberOfThreads; j += 1) pthread_join(threads[j], NULL);
+
+    double elapsed = getSeconds() - startTime;
+
+    writeShots();
+
+    fprintf(stderr, "%u groups of recordings from %u devices located in %.2f seconds\n", numberOfGroups, numberOfDevices, elapsed);
+
+    for (uint32_t j = 0; j <= MAXIMUM_FFT_ORDER; j += 1) destroyFFTPlan(plans[j]);
+
+    freeFleetDirectory(devices, numberOfDevices);
+
+    return 0;
+
+}
@@ -0,0 +1,160 @@
+/****************************************************************************
+ * wavfile.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "wavfile.h"
+
+#define PCM_FORMAT                          1
+
+static uint32_t readLittleEndian(const uint8_t *bytes, uint32_t length) {
+
+    uint32_t value = 0;
+
+    for (uint32_t i = 0; i < length; i += 1) {
+
+        value |= (uint32_t)bytes[i] << (8 * i);
+
+    }
+
+    return value;
+
+}
+
+int16_t* readWavFile(const char *filename, uint32_t *sampleRate, uint32_t *numberOfSamples) {
+
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL) return NULL;
+
+    uint8_t header[12];
+
+    if (fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+
+        fclose(file);
+
+        return NULL;
+
+    }
+
+    bool formatValid = false;
+
+    /* Walk the chunks until the data chunk, checking the format chunk on the way */
+
+    uint8_t chunkHeader[8];
+
+    while (fread(chunkHeader, 1, 8, file) == 8) {
+
+        uint32_t chunkSize = readLittleEndian(chunkHeader + 4, 4);
+
+        if (memcmp(chunkHeader, "fmt ", 4) == 0 && chunkSize >= 16) {
+
+            uint8_t format[16];
+
+            if (fread(format, 1, 16, file) != 16) break;
+
+            uint32_t formatTag = readLittleEndian(format, 2);
+
+            uint32_t numberOfChannels = readLittleEndian(format + 2, 2);
+
+            uint32_t bitsPerSample = readLittleEndian(format + 14, 2);
+
+            *sampleRate = readLittleEndian(format + 4, 4);
+
+            formatValid = formatTag == PCM_FORMAT && numberOfChannels == 1 && bitsPerSample == 16;
+
+            fseek(file, chunkSize - 16 + (chunkSize & 1), SEEK_CUR);
+
+        } else if (memcmp(chunkHeader, "data", 4) == 0 && formatValid) {
+
+            *numberOfSamples = chunkSize / 2;
+
+            uint8_t *bytes = malloc(chunkSize);
+
+            int16_t *samples = malloc(*numberOfSamples * sizeof(int16_t));
+
+            uint32_t bytesRead = bytes == NULL || samples == NULL ? 0 : fread(bytes, 1, chunkSize, file);
+
+            fclose(file);
+
+            if (bytesRead != chunkSize) {
+
+                free(bytes);
+
+                free(samples);
+
+                return NULL;
+
+            }
+
+            for (uint32_t i = 0; i < *numberOfSamples; i += 1) {
+
+                samples[i] = (int16_t)readLittleEndian(bytes + 2 * i, 2);
+
+            }
+
+            free(bytes);
+
+            return samples;
+
+        } else {
+
+            fseek(file, chunkSize + (chunkSize & 1), SEEK_CUR);
+
+        }
+
+    }
+
+    fclose(file);
+
+    return NULL;
+
+}
+
+bool readWavChunk(const char *filename, const char *id, uint8_t *buffer, uint32_t length) {
+
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL) return false;
+
+    uint8_t header[12];
+
+    bool found = false;
+
+    if (fread(header, 1, 12, file) == 12 && memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0) {
+
+        uint8_t chunkHeader[8];
+
+        while (fread(chunkHeader, 1, 8, file) == 8) {
+
+            uint32_t chunkSize = readLittleEndian(chunkHeader + 4, 4);
+
+            if (memcmp(chunkHeader, id, 4) == 0) {
+
+                uint32_t bytesToRead = chunkSize < length ? chunkSize : length;
+
+                memset(buffer, 0, length);
+
+                found = fread(buffer, 1, bytesToRead, file) == bytesToRead;
+
+                break;
+
+            }
+
+            fseek(file, chunkSize + (chunkSize & 1), SEEK_CUR);
+
+        }
+
+    }
+
+    fclose(file);
+
+    return found;
+
+}
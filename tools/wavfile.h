@@ -0,0 +1,21 @@
+/****************************************************************************
+ * wavfile.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef WAVFILE_H_
+#define WAVFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Read a 16-bit mono PCM WAV file into a newly allocated buffer. Returns NULL on failure */
+
+int16_t* readWavFile(const char *filename, uint32_t *sampleRate, uint32_t *numberOfSamples);
+
+/* Read up to length bytes of the first chunk with the given four character id. Returns false if the file has no such chunk */
+
+bool readWavChunk(const char *filename, const char *id, uint8_t *buffer, uint32_t length);
+
+#endif /* WAVFILE_H_ */